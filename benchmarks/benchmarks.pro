@@ -0,0 +1,25 @@
+#Todi library building benchmark, run it from a release build
+QT -= gui
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = librarybuilder-benchmark
+TEMPLATE = app
+
+INCLUDEPATH += ../src ../src/lib
+
+HEADERS += ../src/lib/mpdarena.h \
+           ../src/lib/mpdlibrarybuilder.h \
+           ../src/lib/mpdlibrarymodel.h \
+           ../src/lib/mpdmodel.h \
+           ../src/lib/mpdsearchindex.h \
+           ../src/lib/mpdsongtable.h \
+           ../src/lib/mpdstringpool.h
+
+SOURCES += librarybuilder.cpp \
+           ../src/lib/mpdarena.cpp \
+           ../src/lib/mpdlibrarybuilder.cpp \
+           ../src/lib/mpdlibrarymodel.cpp \
+           ../src/lib/mpdsearchindex.cpp \
+           ../src/lib/mpdsongtable.cpp \
+           ../src/lib/mpdstringpool.cpp
@@ -0,0 +1,120 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Times building the library tree from synthetic listallinfo batches of
+// 1k up to 1M songs, as LibraryModel::appendSongs() feeds them to the
+// builder, & ordering it once complete. Building should scale linearly.
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QList>
+#include <QStringList>
+#include <QTextStream>
+
+#include "lib/mpdlibrarybuilder.h"
+#include "lib/mpdmodel.h"
+#include "lib/mpdstringpool.h"
+
+namespace {
+// about what MPD sends per chunk of a large listallinfo reply
+const int batchSize = 500;
+const int songsPerAlbum = 12;
+const int albumsPerArtist = 5;
+
+// tag values as the parser hands them on, through the pool
+QString pooled(const QString &value) {
+  const QByteArray utf8 = value.toUtf8();
+  return MPDStringPool::instance().intern(utf8.constData(), utf8.size());
+}
+
+// Songs in the order listallinfo has them, grouped by directory
+QList<QList<MPDSongMetadata>> makeBatches(const int songCount) {
+  static const QStringList genres = {"Rock", "Jazz", "Classical", "Pop"};
+  QList<QList<MPDSongMetadata>> batches;
+  QList<MPDSongMetadata> batch;
+  for (int i = 0; i < songCount; i++) {
+    const int album = i / songsPerAlbum;
+    const int artist = album / albumsPerArtist;
+    MPDSongMetadata song;
+    song.artist = pooled(QString("Artist %1").arg(artist));
+    song.albumArtist = song.artist;
+    song.album = pooled(QString("Album %1").arg(album));
+    // tracks as they often are, in file order but not in title order
+    song.track = static_cast<quint16>(i % songsPerAlbum + 1);
+    song.title = QString("Title %1").arg(qint64(i) * 7919 % songCount);
+    song.file = QString("%1/%2/%3 - %4.flac")
+                    .arg(song.artist, song.album)
+                    .arg(song.track, 2, 10, QChar('0'))
+                    .arg(song.title);
+    song.genre = pooled(genres.at(artist % genres.size()));
+    song.date = static_cast<quint16>(1960 + album % 60);
+    song.disc = 1;
+    song.time = static_cast<quint16>(180 + i % 120);
+    batch.append(song);
+    if (batch.size() == batchSize) {
+      batches.append(batch);
+      batch.clear();
+    }
+  }
+  if (!batch.isEmpty()) batches.append(batch);
+  return batches;
+}
+
+// the runs of songs of an album LibraryModel::appendSongs() adds at once
+void appendSongs(MusicLibraryBuilder *builder,
+                 const QList<MPDSongMetadata> &songs) {
+  for (int first = 0, last = 0; first < songs.size(); first = last) {
+    const MPDSongMetadata &song = songs.at(first);
+    for (last = first + 1; last < songs.size(); last++) {
+      if (songs.at(last).artist != song.artist ||
+          songs.at(last).album != song.album)
+        break;
+    }
+    MusicLibraryItemArtist *artistItem = builder->artist(song.artist);
+    if (!artistItem) artistItem = builder->addArtist(song.artist);
+    MusicLibraryItemAlbum *albumItem = builder->album(artistItem, song.album);
+    if (!albumItem) albumItem = builder->addAlbum(artistItem, song.album);
+    builder->addSongs(albumItem, songs, first, last);
+  }
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+  QTextStream out(stdout);
+  out << "songs\tbuild ms\tsort ms\tns/song\n";
+
+  for (const int songCount : {1000, 10000, 100000, 1000000}) {
+    const QList<QList<MPDSongMetadata>> batches = makeBatches(songCount);
+
+    MusicLibraryItemRoot root("Artist / Album / Song");
+    MusicLibraryBuilder builder(&root);
+    QElapsedTimer timer;
+    timer.start();
+    for (const QList<MPDSongMetadata> &batch : batches) {
+      appendSongs(&builder, batch);
+    }
+    const qint64 built = timer.nsecsElapsed();
+    timer.restart();
+    builder.sort();
+    const qint64 sorted = timer.nsecsElapsed();
+
+    out << songCount << '\t' << built / 1000000 << '\t' << sorted / 1000000
+        << '\t' << (built + sorted) / songCount << endl;
+  }
+  return 0;
+}
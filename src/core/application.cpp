@@ -18,6 +18,7 @@
 #include <QThread>
 
 #include "../lib/mpdclient.h"
+#include "../lib/mpdlibrarysearcher.h"
 #include "../tagger/currentartloader.h"
 #include "application.h"
 #include "lazy.h"
@@ -30,9 +31,21 @@ class ApplicationImpl {
           app->MoveToNewThread(currentartloader);
           return currentartloader;
         }),
-        mpdclient_([=]() { return new MPDClient(app); }) {}
+        mpdclient_([=]() {
+          // networking & parsing stay off the GUI thread
+          MPDClient* mpdclient = new MPDClient(app);
+          app->MoveToNewThread(mpdclient);
+          return mpdclient;
+        }),
+        librarysearcher_([=]() {
+          // searches don't hold up typing
+          MPDLibrarySearcher* librarysearcher = new MPDLibrarySearcher(app);
+          app->MoveToNewThread(librarysearcher);
+          return librarysearcher;
+        }) {}
   Lazy<CurrentArtLoader> tagreader_;
   Lazy<MPDClient> mpdclient_;
+  Lazy<MPDLibrarySearcher> librarysearcher_;
 
 };
 
@@ -68,3 +81,7 @@ CurrentArtLoader* Application::currentArtLoader() const {
 }
 
 MPDClient* Application::mpdClient() const { return appimp_->mpdclient_.get(); }
+
+MPDLibrarySearcher* Application::librarySearcher() const {
+  return appimp_->librarysearcher_.get();
+}
@@ -23,6 +23,7 @@
 class ApplicationImpl;
 class CurrentArtLoader;
 class MPDClient;
+class MPDLibrarySearcher;
 
 class Application : public QObject {
   Q_OBJECT
@@ -35,6 +36,7 @@ class Application : public QObject {
 
   CurrentArtLoader* currentArtLoader() const;
   MPDClient* mpdClient() const;
+  MPDLibrarySearcher* librarySearcher() const;
 
  private:
   std::unique_ptr<ApplicationImpl> appimp_;
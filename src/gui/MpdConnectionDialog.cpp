@@ -38,6 +38,15 @@ MpdConnectionDialog::MpdConnectionDialog(QWidget *parent)
   ui_->passwdLineEdit->setText(settings.value("passwd", "").toString());
   settings.endGroup();
 
+  // an absolute path is MPD's unix domain socket, which has no port
+  const auto updatePortEnabled = [this](const QString &host) {
+    ui_->portSpinBox->setEnabled(!host.trimmed().startsWith('/'));
+  };
+  ui_->hostnameLineEdit->setToolTip(
+      tr("Host name, or the path of MPD's socket like /run/mpd/socket"));
+  updatePortEnabled(ui_->hostnameLineEdit->text());
+  connect(ui_->hostnameLineEdit, &QLineEdit::textChanged, updatePortEnabled);
+
   connect(ui_->buttonBox, SIGNAL(accepted()), SLOT(connecttompd()));
   connect(ui_->buttonBox, SIGNAL(rejected()), SLOT(rejectConnection()));
 }
@@ -62,14 +62,18 @@
 #include "widgets/currentcoverartlabel.h"
 #include "widgets/currentsongmetadatalabel.h"
 #include "widgets/metadatawidget.h"
+#include "widgets/searchwidget.h"
 #include "widgets/tabbar.h"
 
+#include "currentplaylistcontroller.h"
 #include "currentplaylistmodel.h"
 #include "currentplaylistview.h"
 #include "models/filemodel.h"
 #include "models/librarymodel.h"
 #include "mpdclient.h"
 #include "mpddata.h"
+#include "mpdlibrarybuilder.h"
+#include "mpdlibrarysearcher.h"
 #include "playbackcontroller.h"
 #include "playbackoptionscontroller.h"
 #include "tagger/currentartloader.h"
@@ -87,6 +91,8 @@ Player::Player(Application *app, QWidget *parent)
       playbackCtrlr_(app_->mpdClient()->getSharedPlaybackControllerPtr()),
       playbackOptionsCtrlr_(
           app_->mpdClient()->getSharedPlaybackOptionsControllerPtr()),
+      currentPlaylistCtrlr_(
+          app_->mpdClient()->getSharedCurrentPlaylistControllerPtr()),
       currentArtLoader_(app_->currentArtLoader()),
       lastState(MPDPlaybackState::Inactive),
       lastSongId(-1),
@@ -113,6 +119,7 @@ Player::Player(Application *app, QWidget *parent)
       fancy_tab_widget(
           new FancyTabWidget(this, FancyTabWidget::Mode::Mode_LargeSidebar)),
       console_widget_(new ConsoleWidget()),
+      search_widget_(new SearchWidget(app_->librarySearcher(), this)),
       playlist_view(new QListView(this)),
       folder_view_(new QTreeView(this)),
       library_view_(new QTreeView(this)),
@@ -182,7 +189,10 @@ Player::Player(Application *app, QWidget *parent)
       theme_, &Theme::themePlaylistviewWidgetChanged,
       [&](QString stylesheet) { playlist_view->setStyleSheet(stylesheet); });
   connect(theme_, &Theme::themeLibraryviewWidgetChanged,
-          [&](QString stylesheet) { library_view_->setStyleSheet(stylesheet); });
+          [&](QString stylesheet) {
+            library_view_->setStyleSheet(stylesheet);
+            search_widget_->setStyleSheet(stylesheet);
+          });
   connect(theme_, &Theme::themeFolderviewWidgetChanged,
           [&](QString stylesheet) { folder_view_->setStyleSheet(stylesheet); });
   connect(theme_, &Theme::themeConsoleWidgetChanged, [&](QString stylesheet) {
@@ -254,6 +264,20 @@ Player::Player(Application *app, QWidget *parent)
   playlist_view->setBatchSize(500);
   playlist_view->setFlow(QListView::TopToBottom);
   playlist_view->setSelectionRectVisible(true);
+  playlist_view->setAcceptDrops(true);
+  playlist_view->setDropIndicatorShown(true);
+  // songs dropped from the library are added, rows dragged within are moved
+  playlist_view->setDragDropMode(QAbstractItemView::DragDrop);
+  playlist_view->setDefaultDropAction(Qt::MoveAction);
+
+  // queue context menu, the actions apply to the selected songs
+  removeSongsAction = new QAction(tr("&Remove"), this);
+  removeSongsAction->setShortcut(QKeySequence::Delete);
+  removeSongsAction->setShortcutContext(Qt::WidgetShortcut);
+  prioritizeSongsAction = new QAction(tr("&Prioritize"), this);
+  playlist_view->addAction(removeSongsAction);
+  playlist_view->addAction(prioritizeSongsAction);
+  playlist_view->setContextMenuPolicy(Qt::ActionsContextMenu);
 
   QGridLayout *baselayout = new QGridLayout(this);
   baselayout->setContentsMargins(5, 5, 5, 5);
@@ -318,6 +342,9 @@ Player::Player(Application *app, QWidget *parent)
   fancy_tab_widget->AddTab(
       folder_view_,
       IconLoader::load("view-media-folder", IconLoader::LightDark), "Folders");
+  fancy_tab_widget->AddTab(
+      search_widget_, IconLoader::load("edit-find", IconLoader::LightDark),
+      "Search");
   fancy_tab_widget->AddTab(
       metadata_widget,
       IconLoader::load("view-media-metadata", IconLoader::LightDark),
@@ -335,6 +362,7 @@ Player::Player(Application *app, QWidget *parent)
   stack_widget->addWidget(playlist_view);
   stack_widget->addWidget(library_view_);
   stack_widget->addWidget(folder_view_);
+  stack_widget->addWidget(search_widget_);
   stack_widget->addWidget(metadata_widget);
   stack_widget->addWidget(console_widget_);
 
@@ -350,17 +378,26 @@ Player::Player(Application *app, QWidget *parent)
   currentCoverArt_label->setFixedWidth(48);
   currentCoverArt_label->setFixedHeight(48);
 
-  currentPlaylistModel_ =
-      new CurrentPlaylistModel(dataAccess_->getPlaylistinfoValues());
+  currentPlaylistModel_ = new CurrentPlaylistModel();
   playlist_view->setModel(currentPlaylistModel_);
 
   // update folder browse view
-  filemodel_ = new FileModel(folder_view_, dataAccess_->getListallValues());
+  filemodel_ = new FileModel(folder_view_, dataAccess_->getFolderTree());
   folder_view_->setModel(filemodel_);
   folder_view_->header()->hide();
 
   librarymodel_ = new LibraryModel(library_view_);
   library_view_->setModel(librarymodel_);
+  library_view_->setSelectionMode(QAbstractItemView::ExtendedSelection);
+  library_view_->setDragDropMode(QAbstractItemView::DragOnly);
+
+  // library context menu
+  albumsByDateAction = new QAction(tr("Order Albums by &Date"), this);
+  albumsByDateAction->setCheckable(true);
+  albumsByDateAction->setChecked(MusicLibraryBuilder::albumOrder() ==
+                                 MusicLibraryBuilder::AlbumOrder::Date);
+  library_view_->addAction(albumsByDateAction);
+  library_view_->setContextMenuPolicy(Qt::ActionsContextMenu);
 
   this->setMouseTracking(true);
 
@@ -488,12 +525,26 @@ Player::Player(Application *app, QWidget *parent)
   //        [&](int vol) { mpd.setVolume(static_cast<quint8>(vol)); });
   connect(volume_pushButton, &QPushButton::clicked, this,
           &Player::showVolumeSlider);
+  connect(search_pushButton, &QPushButton::clicked, [=]() {
+    fancy_tab_widget->SetCurrentIndex(stack_widget->indexOf(search_widget_));
+    search_widget_->focusQuery();
+  });
 
-  // Timer time out update status
+  // Timer time out, polls the status only if idle is not available
   statusTimer.start(settings.value("getstatus-interval", 1000).toInt());
   // statusTimer.start(10000);
-  connect(&statusTimer, &QTimer::timeout, dataAccess_.get(),
+  connect(&statusTimer, &QTimer::timeout, this, &Player::statusTimerTick);
+  connect(mpdClient_, &MPDClient::idleUnavailable, dataAccess_.get(),
           &MPDdata::getMPDStatus);
+  connect(mpdClient_, &MPDClient::connectionHealthChanged, this,
+          [](const QList<MPDConnectionHealth> &connections) {
+            for (const MPDConnectionHealth &connection : connections) {
+              qInfo() << "MPD connection" << connection.name
+                      << (connection.healthy ? "healthy" : "unhealthy")
+                      << "pending:" << connection.pendingCommands
+                      << "latency:" << connection.latency << "ms";
+            }
+          });
 
   // Volume popup signal handling
   connect(volume_popup, &VolumePopup::volumePopupSliderChanged, this,
@@ -506,32 +557,112 @@ Player::Player(Application *app, QWidget *parent)
 
   // Update MetadataWidget
   connect(dataAccess_.get(), &MPDdata::MPDSongMetadataUpdated, [&]() {
-    metadata_widget->setMetadata(dataAccess_->getSongMetadataValues());
+    metadata_widget->setMetadata(dataAccess_->getSongMetadataValues().get());
   });
 
-  // Update Folder View
-  connect(dataAccess_.get(), &MPDdata::MPDListallUpdated, filemodel_,
+  // Update Folder View, folders are listed as they are expanded
+  connect(dataAccess_.get(), &MPDdata::MPDFolderTreeUpdated, filemodel_,
           &FileModel::ViewUpdated);
+  connect(filemodel_, &FileModel::directoryRequested, dataAccess_.get(),
+          &MPDdata::getMPDDirectory);
+  connect(dataAccess_.get(), &MPDdata::MPDDirectoryFetched, filemodel_,
+          &FileModel::directoryFetched);
 
   // update current playlist model
   connect(dataAccess_.get(), &MPDdata::MPDPlaylistinfoUpdated,
           currentPlaylistModel_, &CurrentPlaylistModel::updateModel);
+  connect(dataAccess_.get(), &MPDdata::MPDPlaylistChanged,
+          currentPlaylistModel_, &CurrentPlaylistModel::applyChanges);
+  connect(dataAccess_.get(), &MPDdata::MPDPlaylistResized,
+          currentPlaylistModel_, &CurrentPlaylistModel::resize);
+  connect(currentPlaylistModel_, &CurrentPlaylistModel::rangeRequested,
+          dataAccess_.get(), &MPDdata::getMPDPlaylistRange);
+  connect(dataAccess_.get(), &MPDdata::MPDPlaylistRangeFetched,
+          currentPlaylistModel_, &CurrentPlaylistModel::rangeFetched);
   connect(this, &Player::songChanged, currentPlaylistModel_,
           &CurrentPlaylistModel::updateCurrentSong);
   connect(playlist_view, &QListView::doubleClicked, currentPlaylistModel_,
           &CurrentPlaylistModel::doubleClicked);
   connect(currentPlaylistModel_, &CurrentPlaylistModel::playSong,
           [=](const quint32 song) { playbackCtrlr_->play(song); });
+  connect(currentPlaylistModel_, &CurrentPlaylistModel::addSongs,
+          [=](const QStringList &filenames, const qint32 position) {
+            currentPlaylistCtrlr_->add(filenames, position);
+          });
+
+  // Queue edits show at once, the whole queue is fetched again if MPD
+  // failed to carry one out
+  const MPDCommandListHandler queueEdited =
+      [=](const QList<QPair<QByteArray, bool>> &, const int failedIndex) {
+        if (failedIndex != -1) dataAccess_->reloadMPDPlaylistInfo();
+      };
+  connect(currentPlaylistModel_, &CurrentPlaylistModel::removeSongs,
+          [=](const QList<qint32> &positions) {
+            currentPlaylistCtrlr_->remove(positions, queueEdited);
+          });
+  connect(currentPlaylistModel_, &CurrentPlaylistModel::moveSongs,
+          [=](const QList<qint32> &positions, const qint32 to) {
+            currentPlaylistCtrlr_->move(positions, to, queueEdited);
+          });
+  connect(currentPlaylistModel_, &CurrentPlaylistModel::prioritizeSongs,
+          [=](const QList<qint32> &positions, const quint8 priority) {
+            currentPlaylistCtrlr_->prioritize(positions, priority,
+                                              queueEdited);
+          });
+  connect(currentPlaylistModel_, &CurrentPlaylistModel::outOfStep,
+          dataAccess_.get(), &MPDdata::reloadMPDPlaylistInfo);
+  connect(removeSongsAction, &QAction::triggered, [=]() {
+    currentPlaylistModel_->removeSongsAt(selectedQueueRows());
+  });
+  connect(prioritizeSongsAction, &QAction::triggered, [=]() {
+    currentPlaylistModel_->prioritizeSongsAt(selectedQueueRows(), 255);
+  });
+
+  // Update Library View, it fills while the library is being received
+  connect(dataAccess_.get(), &MPDdata::MPDLibraryUpdateStarted, librarymodel_,
+          &LibraryModel::beginLibraryUpdate);
+  connect(dataAccess_.get(), &MPDdata::MPDLibrarySongsReceived, librarymodel_,
+          &LibraryModel::appendSongs);
+  connect(dataAccess_.get(), &MPDdata::MPDLibraryUpdateFinished,
+          librarymodel_, [=](const bool complete) {
+            librarymodel_->finishLibraryUpdate(
+                complete, QDateTime::fromTime_t(dataAccess_->dbUpdate()));
+          });
+  connect(librarymodel_, &LibraryModel::libraryChanged,
+          app_->librarySearcher(), &MPDLibrarySearcher::setLibrary);
+  // a library received aside is ordered in the MPD thread, then takes over
+  connect(librarymodel_, &LibraryModel::libraryCompleted, dataAccess_.get(),
+          &MPDdata::orderLibrary);
+  connect(dataAccess_.get(), &MPDdata::MPDLibraryOrdered, librarymodel_,
+          [=](MusicLibraryItemRoot *library, const QDateTime &dbUpdate) {
+            librarymodel_->updateLibrary(library, dbUpdate);
+          });
+  connect(albumsByDateAction, &QAction::toggled, [=](const bool byDate) {
+    MusicLibraryBuilder::setAlbumOrder(
+        byDate ? MusicLibraryBuilder::AlbumOrder::Date
+               : MusicLibraryBuilder::AlbumOrder::Title);
+    librarymodel_->updateAlbumOrder();
+  });
+  // The cache is written in the MPD thread, the library's songs stay
+  // unmodified. Its order is taken here, where the albums are reordered.
+  connect(librarymodel_, &LibraryModel::libraryReceived, librarymodel_,
+          [=](const MPDLibrarySnapshot &library, const QDateTime &dbUpdate) {
+            dataAccess_->writeLibraryCache(
+                Todi::hostname, library, MPDLibraryCache::order(library.get()),
+                dbUpdate);
+          });
+  connect(dataAccess_.get(), &MPDdata::MPDLibraryCacheLoaded, librarymodel_,
+          [=](MusicLibraryItemRoot *library, const QDateTime &dbUpdate) {
+            librarymodel_->updateLibrary(library, dbUpdate, true);
+          });
   // metadata single slingshot
   QTimer::singleShot(3000, this, showMetadataSlingshot);
 
-  // update status & stats when starting the application
+  // Only status & stats are fetched when starting the application, the
+  // first status fetches the queue. The library & folders are read from the
+  // cache in the MPD thread & refreshed only if the database has changed.
   dataAccess_->getMPDStatus();
-  dataAccess_->getMPDStats();
-  dataAccess_->getMPDListall();
-  dataAccess_->getMPDPlaylistInfo();
-  dataAccess_->getMPDLibrary();
-  librarymodel_->updateLibrary(dataAccess_->getLibraryValues());
+  dataAccess_->loadCachedListings(Todi::hostname);
 }
 
 QSize Player::sizeHint() const { return QSize(100, 40); }
@@ -642,6 +773,15 @@ bool Player::eventFilter(QObject *target, QEvent *event) {
   return QWidget::eventFilter(target, event);
 }
 
+QList<qint32> Player::selectedQueueRows() const {
+  QList<qint32> rows;
+  for (const QModelIndex &index :
+       playlist_view->selectionModel()->selectedIndexes()) {
+    rows.append(index.row());
+  }
+  return rows;
+}
+
 int Player::showMpdConnectionDialog() {
   std::unique_ptr<MpdConnectionDialog> connect(new MpdConnectionDialog(this));
   return connect->exec();
@@ -696,7 +836,7 @@ void Player::updateStats() {
 }
 
 void Player::updateStatus() {
-  QString timeElapsedFormattedString;
+  statusAge_.start();
 
   // Retrieve stats every 5 seconds
   // fetchStatsFactor = (fetchStatsFactor + 1) % 5;
@@ -736,16 +876,9 @@ void Player::updateStatus() {
     play_pause_pushButton->setEnabled(true);
     timer_label->setText("00:00");
     return;
-  } else {
-    timeElapsedFormattedString +=
-        QString::number(floor(dataAccess_->timeElapsed() / 60.0));
-    timeElapsedFormattedString += ":";
-    if (dataAccess_->timeElapsed() % 60 < 10) timeElapsedFormattedString += "0";
-    timeElapsedFormattedString +=
-        QString::number(dataAccess_->timeElapsed() % 60);
   }
 
-  timer_label->setText(timeElapsedFormattedString);
+  setTimeElapsed(dataAccess_->timeElapsed());
 
   switch (dataAccess_->state()) {
     case MPDPlaybackState::Playing:
@@ -819,15 +952,52 @@ void Player::updateStatus() {
   lastPlaylist = dataAccess_->playlist();
 }
 
+void Player::statusTimerTick() {
+  // nothing to poll while the client is reconnecting
+  if (mpdClient_->connectionState() != MPDClient::ConnectionState::Connected) {
+    return;
+  }
+
+  if (!mpdClient_->isIdleActive()) {
+    dataAccess_->getMPDStatus();
+    return;
+  }
+
+  // idle only reports state changes, keep the clock running meanwhile
+  if (dataAccess_->state() != MPDPlaybackState::Playing) return;
+
+  const qint32 timeElapsed = qMin(
+      dataAccess_->timeElapsed() +
+          static_cast<qint32>(statusAge_.elapsed() / 1000),
+      dataAccess_->timeTotal());
+  if (!draggingPositionSlider) track_slider->setValue(timeElapsed);
+  setTimeElapsed(timeElapsed);
+  if (dataAccess_->consume()) doConsumePingpong();
+}
+
+void Player::setTimeElapsed(const qint32 timeElapsed) {
+  QString timeElapsedFormattedString;
+  timeElapsedFormattedString += QString::number(floor(timeElapsed / 60.0));
+  timeElapsedFormattedString += ":";
+  if (timeElapsed % 60 < 10) timeElapsedFormattedString += "0";
+  timeElapsedFormattedString += QString::number(timeElapsed % 60);
+
+  timer_label->setText(timeElapsedFormattedString);
+}
+
 void Player::playPauseTrack() const {
   if (dataAccess_->state() == MPDPlaybackState::Playing) {
     playbackCtrlr_->pause(1);
   } else if (dataAccess_->state() == MPDPlaybackState::Paused) {
     playbackCtrlr_->pause(0);
   } else {
-    if (!playbackCtrlr_->playId(lastSongId)) {
-      playbackCtrlr_->play(0);
-    }
+    playbackCtrlr_->playId(
+        lastSongId, [this](const QPair<QByteArray, bool> &reply) {
+          if (!reply.second) {
+            playbackCtrlr_->play(0);
+            dataAccess_->getMPDStatus();
+          }
+        });
   }
 
   dataAccess_->getMPDStatus();
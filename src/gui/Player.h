@@ -19,6 +19,7 @@
 #ifndef PLAYER_H
 #define PLAYER_H
 
+#include <QElapsedTimer>
 #include <QLabel>
 #include <QObject>
 #include <QPushButton>
@@ -41,6 +42,7 @@ class MPDClient;
 class MPDdata;
 class PlaybackController;
 class PlaybackOptionsController;
+class CurrentPlaylistController;
 class TrackSlider;
 class VolumePopup;
 class CurrentArtLoader;
@@ -52,6 +54,7 @@ class FileModel;
 class LibraryModel;
 class FancyTabWidget;
 class ConsoleWidget;
+class SearchWidget;
 class Theme;
 class QListView;
 class QTreeView;
@@ -83,6 +86,7 @@ class Player : public QWidget {
   std::shared_ptr<MPDdata> dataAccess_;
   std::shared_ptr<PlaybackController> playbackCtrlr_;
   std::shared_ptr<PlaybackOptionsController> playbackOptionsCtrlr_;
+  std::shared_ptr<CurrentPlaylistController> currentPlaylistCtrlr_;
   CurrentArtLoader *currentArtLoader_;
 
   MPDPlaybackState lastState;
@@ -92,6 +96,9 @@ class Player : public QWidget {
   int fetchStatsFactor;
   int nowPlayingFactor;
   QTimer statusTimer;
+  // time since the last status, used to advance the elapsed time locally
+  // while status updates are pushed through idle
+  QElapsedTimer statusAge_;
 
   bool draggingPositionSlider;
   QLabel bitrateLabel;
@@ -114,6 +121,7 @@ class Player : public QWidget {
   MetadataWidget *metadata_widget;
   FancyTabWidget *fancy_tab_widget;
   ConsoleWidget *console_widget_;
+  SearchWidget *search_widget_;
   QListView *playlist_view;
   QTreeView *folder_view_;
   QTreeView *library_view_;
@@ -131,6 +139,9 @@ class Player : public QWidget {
   QAction *consumeAction;
   QAction *quitAction;
   QAction *aboutAction;
+  QAction *removeSongsAction;
+  QAction *prioritizeSongsAction;
+  QAction *albumsByDateAction;
   bool consumePingpong;
   bool nonConsumeSlider;
   bool show_metadata_on_mouse_leave_;
@@ -144,12 +155,15 @@ class Player : public QWidget {
   void doConsumePingpong();
   void restoreTrackSliderHandle();
   void setTrackSliderHandleToConsume();
+  void setTimeElapsed(const qint32 timeElapsed);
+  QList<qint32> selectedQueueRows() const;
 
  private slots:
   void expandCollapse();
   void showVolumeSlider();
   void updateStats();
   void updateStatus();
+  void statusTimerTick();
   void playPauseTrack() const;
   void stopTrack() const;
   void positionSliderPressed();
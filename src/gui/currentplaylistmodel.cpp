@@ -1,11 +1,43 @@
 #include "currentplaylistmodel.h"
+#include "../lib/mpdqueuerange.h"
+#include "../models/librarymimedata.h"
+#include <QDataStream>
 #include <QDebug>
+#include <QHash>
+#include <QMimeData>
 #include <QPixmap>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+#include <algorithm>
 
-CurrentPlaylistModel::CurrentPlaylistModel(
-    QList<MPDSongMetadata *> *playlistQueue, QObject *parent)
+static const QString songsMimeType("application/qtmpc_songs_filename_text");
+// rows of the queue dragged within it
+static const QString queueRowsMimeType("application/x-todi-queue-rows");
+
+// a screenful or two of rows
+const int CurrentPlaylistModel::pageSize_ = 256;
+const int CurrentPlaylistModel::maxPages_ = 32;
+const int CurrentPlaylistModel::maxMoves_ = 64;
+
+// the position aside, which shifts with every edit in front of the song
+static bool sameTags(const MPDSongMetadata &a, const MPDSongMetadata &b) {
+  return a.file == b.file && a.artist == b.artist && a.album == b.album &&
+         a.albumId == b.albumId && a.albumArtist == b.albumArtist &&
+         a.title == b.title && a.track == b.track && a.name == b.name &&
+         a.genre == b.genre && a.date == b.date && a.composer == b.composer &&
+         a.performer == b.performer && a.comment == b.comment &&
+         a.disc == b.disc && a.time == b.time && a.id == b.id &&
+         a.lastModified == b.lastModified;
+}
+
+CurrentPlaylistModel::CurrentPlaylistModel(QObject *parent)
     : QAbstractListModel(parent),
-      playlistQueue_(playlistQueue),
+      virtual_(false),
+      version_(0),
+      length_(0),
+      pages_(maxPages_),
+      lastPage_(0),
       song_id(-1),
       lastsong_id(-1) {}
 
@@ -22,7 +54,7 @@ QVariant CurrentPlaylistModel::headerData(int section,
 
 int CurrentPlaylistModel::rowCount(const QModelIndex &parent) const {
   Q_UNUSED(parent)
-  return playlistQueue_->size();
+  return virtual_ ? length_ : playlistQueue_.size();
 }
 
 QVariant CurrentPlaylistModel::data(const QModelIndex &index, int role) const {
@@ -31,16 +63,16 @@ QVariant CurrentPlaylistModel::data(const QModelIndex &index, int role) const {
     return QVariant();
   }
   // out of bound row value
-  if (index.row() >= playlistQueue_->size()) return QVariant();
+  if (index.row() >= rowCount()) return QVariant();
 
-  MPDSongMetadata *metadata = playlistQueue_->at(index.row());
-  if (!metadata) return QString("no metadata");
+  // the row of a virtual queue is empty until its page arrives
+  const MPDSongMetadata *metadata = song(index.row());
 
   switch (role) {
     case Qt::DisplayRole:
-      return (metadata->title);
+      return metadata ? metadata->title : QVariant();
     case Qt::UserRole:
-      return (metadata->album);
+      return metadata ? metadata->album : QVariant();
     case Qt::DecorationRole:
       return (QPixmap(":/icons/nocover.png"));
   }
@@ -49,6 +81,88 @@ QVariant CurrentPlaylistModel::data(const QModelIndex &index, int role) const {
   return QVariant();
 }
 
+Qt::ItemFlags CurrentPlaylistModel::flags(const QModelIndex &index) const {
+  if (index.isValid())
+    return QAbstractListModel::flags(index) | Qt::ItemIsDragEnabled |
+           Qt::ItemIsDropEnabled;
+  else
+    return Qt::ItemIsDropEnabled;
+}
+
+QStringList CurrentPlaylistModel::mimeTypes() const {
+  return QStringList() << songsMimeType << queueRowsMimeType;
+}
+
+QMimeData *CurrentPlaylistModel::mimeData(
+    const QModelIndexList &indexes) const {
+  QByteArray encodedData;
+  QDataStream stream(&encodedData, QIODevice::WriteOnly);
+  for (const QModelIndex &index : indexes) {
+    stream << static_cast<qint32>(index.row());
+  }
+  QMimeData *mimeData = new QMimeData();
+  mimeData->setData(queueRowsMimeType, encodedData);
+  return mimeData;
+}
+
+Qt::DropActions CurrentPlaylistModel::supportedDropActions() const {
+  return Qt::CopyAction | Qt::MoveAction;
+}
+
+/**
+ * Songs dropped from the library, the filenames are added to MPD in one go.
+ * Rows of the queue itself are moved there.
+ */
+bool CurrentPlaylistModel::dropMimeData(const QMimeData *data,
+                                        Qt::DropAction action, int row,
+                                        int /*column*/,
+                                        const QModelIndex &parent) {
+  if (action == Qt::IgnoreAction) return true;
+
+  // dropped on an item rather than between two of them
+  if (row == -1 && parent.isValid()) row = parent.row();
+
+  if (data->hasFormat(queueRowsMimeType)) {
+    QByteArray encodedData = data->data(queueRowsMimeType);
+    QDataStream stream(&encodedData, QIODevice::ReadOnly);
+    QList<qint32> rows;
+    qint32 draggedRow;
+    while (!stream.atEnd()) {
+      stream >> draggedRow;
+      rows.append(draggedRow);
+    }
+    moveSongsTo(rows, (row < 0 || row > rowCount()) ? rowCount() : row);
+    // the rows are moved already, nothing for the view to remove
+    return false;
+  }
+  if (!data->hasFormat(songsMimeType)) return false;
+
+  QStringList filenames;
+  const LibraryMimeData *librarySongs =
+      qobject_cast<const LibraryMimeData *>(data);
+  if (librarySongs) {
+    // only the dragged items came along, their songs are looked up now
+    filenames = librarySongs->filenames();
+  } else {
+    QByteArray encodedData = data->data(songsMimeType);
+    QDataStream stream(&encodedData, QIODevice::ReadOnly);
+    QString filename;
+
+    // the filenames are streamed last to first
+    while (!stream.atEnd()) {
+      stream >> filename;
+      filenames.prepend(filename);
+    }
+  }
+
+  if (filenames.isEmpty()) return false;
+
+  emit addSongs(filenames, (row < 0 || row >= rowCount())
+                               ? -1
+                               : getRowPos(row));
+  return true;
+}
+
 void CurrentPlaylistModel::updateCurrentSong(quint32 id) {
   lastsong_id = song_id;
   song_id = id;
@@ -62,33 +176,327 @@ void CurrentPlaylistModel::updateCurrentSong(quint32 id) {
 }
 
 qint32 CurrentPlaylistModel::getRowId(qint32 row) const {
-  if (playlistQueue_->size() <= row) {
-    return -1;
-  }
-  return playlistQueue_->at(row)->id;
+  const MPDSongMetadata *metadata = row < rowCount() ? song(row) : nullptr;
+  return metadata ? metadata->id : -1;
 }
 
 qint32 CurrentPlaylistModel::getRowPos(qint32 row) const {
-  if (playlistQueue_->size() <= row) {
+  if (rowCount() <= row) {
     return -1;
   }
-  return playlistQueue_->at(row)->pos;
+  return row;
 }
 
 /* call this when the application starts & when thre is a change to current
    playlist outside Todi (probably from other clients). Avoid it otherwise for
    small operations */
-void CurrentPlaylistModel::updateModel() {
+void CurrentPlaylistModel::updateModel(
+    const MPDPlaylistSnapshot &playlistQueue) {
   beginResetModel();
+  playlistQueue_ = *playlistQueue;
+  virtual_ = false;
+  pages_.clear();
+  pendingPages_.clear();
   endResetModel();
 }
 
+void CurrentPlaylistModel::applyChanges(
+    const MPDQueueChangesSnapshot &changes) {
+  const int length = static_cast<int>(changes->length);
+  // the songs each position ends up with, those not listed stay
+  QVector<qint32> ids(length, -1);
+  for (int row = 0; row < qMin(length, playlistQueue_.size()); row++) {
+    ids[row] = playlistQueue_.at(row).id;
+  }
+  QHash<qint32, const MPDSongMetadata *> listed;
+  for (const MPDSongMetadata &song : changes->songs) {
+    if (static_cast<int>(song.pos) >= length) continue;
+    ids[static_cast<int>(song.pos)] = song.id;
+    listed.insert(song.id, &song);
+  }
+  QSet<qint32> kept;
+  kept.reserve(length);
+  for (const qint32 id : ids) kept.insert(id);
+  // an id twice, an edit made here crossed with one made elsewhere
+  if (kept.size() != length) {
+    emit outOfStep();
+    return;
+  }
+  QSet<qint32> held;
+  held.reserve(playlistQueue_.size());
+  for (const MPDSongMetadata &song : playlistQueue_) held.insert(song.id);
+
+  // An edit made here that MPD did not carry out leaves the changes
+  // without the songs they need
+  for (const qint32 id : ids) {
+    const MPDSongMetadata *song = listed.value(id);
+    if (!held.contains(id) && (!song || song->file.isEmpty())) {
+      emit outOfStep();
+      return;
+    }
+  }
+
+  // the songs that left the queue, a run of them at a time
+  for (int last = playlistQueue_.size() - 1; last >= 0; last--) {
+    if (kept.contains(playlistQueue_.at(last).id)) continue;
+    int first = last;
+    while (first > 0 && !kept.contains(playlistQueue_.at(first - 1).id)) {
+      first--;
+    }
+    beginRemoveRows(QModelIndex(), first, last);
+    playlistQueue_.erase(playlistQueue_.begin() + first,
+                         playlistQueue_.begin() + last + 1);
+    endRemoveRows();
+    last = first;
+  }
+
+  // Then the runs of new songs at their positions, which is where they
+  // belong unless the songs held were reordered as well
+  for (int pos = 0; pos < length; pos++) {
+    if (held.contains(ids.at(pos))) continue;
+    int last = pos;
+    while (last + 1 < length && !held.contains(ids.at(last + 1))) last++;
+    const int row = qMin(pos, playlistQueue_.size());
+    beginInsertRows(QModelIndex(), row, row + last - pos);
+    for (int i = pos; i <= last; i++) {
+      playlistQueue_.insert(row + i - pos, *listed.value(ids.at(i)));
+    }
+    endInsertRows();
+    pos = last;
+  }
+
+  // MPD lists every song a removal or insert shifted, those are in place
+  // by now. What is left out of place was moved. The moves are worked out
+  // on the ids first, a shuffled queue is cheaper to show as a reset.
+  QVector<QPair<int, int>> moves;
+  if (!planMoves(ids, &moves)) {
+    QHash<qint32, const MPDSongMetadata *> heldSongs;
+    for (const MPDSongMetadata &song : playlistQueue_) {
+      heldSongs.insert(song.id, &song);
+    }
+    QList<MPDSongMetadata> playlistQueue;
+    playlistQueue.reserve(length);
+    for (const qint32 id : ids) {
+      const MPDSongMetadata *song = listed.value(id);
+      if (!song || song->file.isEmpty()) song = heldSongs.value(id);
+      playlistQueue.append(*song);
+    }
+    beginResetModel();
+    playlistQueue_.swap(playlistQueue);
+    endResetModel();
+    return;
+  }
+  for (const QPair<int, int> &move : moves) {
+    // the destination is the row the song ends up in front of
+    beginMoveRows(QModelIndex(), move.first, move.first, QModelIndex(),
+                  move.second > move.first ? move.second + 1 : move.second);
+    playlistQueue_.move(move.first, move.second);
+    endMoveRows();
+  }
+
+  // the tags that changed, of songs moved or in place alike
+  for (const MPDSongMetadata &song : changes->songs) {
+    const int pos = static_cast<int>(song.pos);
+    if (pos >= length || song.file.isEmpty()) continue;
+    if (sameTags(playlistQueue_.at(pos), song)) continue;
+    playlistQueue_[pos] = song;
+    emit dataChanged(index(pos), index(pos));
+  }
+}
+
+bool CurrentPlaylistModel::planMoves(const QVector<qint32> &ids,
+                                     QVector<QPair<int, int>> *moves) const {
+  if (playlistQueue_.size() != ids.size()) return false;
+  QVector<qint32> rows;
+  rows.reserve(playlistQueue_.size());
+  for (const MPDSongMetadata &song : playlistQueue_) rows.append(song.id);
+  QHash<qint32, int> positions;
+  positions.reserve(ids.size());
+  for (int pos = 0; pos < ids.size(); pos++) positions.insert(ids.at(pos), pos);
+
+  // Each position gets its song, the rows before it are final. A song that
+  // belongs further down while the next one belongs here is moved down in
+  // one go, rather than moving each song it passed up by one.
+  for (int pos = 0; pos < ids.size(); pos++) {
+    if (rows.at(pos) == ids.at(pos)) continue;
+    if (moves->size() == maxMoves_) return false;
+    int from = pos;
+    int to = pos;
+    if (pos + 1 < rows.size() && rows.at(pos + 1) == ids.at(pos)) {
+      to = positions.value(rows.at(pos));
+    } else {
+      from = rows.indexOf(ids.at(pos), pos + 1);
+      if (from == -1) return false;
+    }
+    if (from < to) {
+      std::rotate(rows.begin() + from, rows.begin() + from + 1,
+                  rows.begin() + to + 1);
+    } else {
+      std::rotate(rows.begin() + to, rows.begin() + from,
+                  rows.begin() + from + 1);
+    }
+    moves->append(qMakePair(from, to));
+  }
+  return true;
+}
+
+void CurrentPlaylistModel::removeSongsAt(const QList<qint32> &rows) {
+  const QList<MPDQueueRange::Range> ranges = MPDQueueRange::ranges(rows);
+  if (ranges.isEmpty()) return;
+  emit removeSongs(rows);
+  // rows of a virtual queue are shown anew once MPD reports the change
+  if (virtual_) return;
+
+  for (int i = ranges.size() - 1; i >= 0; i--) {
+    const MPDQueueRange::Range &range = ranges.at(i);
+    beginRemoveRows(QModelIndex(), range.first, range.second - 1);
+    playlistQueue_.erase(playlistQueue_.begin() + range.first,
+                         playlistQueue_.begin() + range.second);
+    endRemoveRows();
+  }
+}
+
+void CurrentPlaylistModel::moveSongsTo(const QList<qint32> &rows,
+                                       const qint32 row) {
+  const QList<MPDQueueRange::Range> ranges = MPDQueueRange::ranges(rows, row);
+  if (ranges.isEmpty()) return;
+  emit moveSongs(rows, row);
+  if (virtual_) return;
+
+  // the same moves CurrentPlaylistController::move has MPD make, except a
+  // row's destination is given as the row it ends up in front of
+  qint32 cursor = row;
+  for (int i = ranges.size() - 1; i >= 0; i--) {
+    const MPDQueueRange::Range &range = ranges.at(i);
+    if (range.first >= row) continue;
+    const qint32 length = range.second - range.first;
+    if (range.second != cursor) {
+      beginMoveRows(QModelIndex(), range.first, range.second - 1,
+                    QModelIndex(), cursor);
+      for (qint32 moved = 0; moved < length; moved++) {
+        playlistQueue_.move(range.first, cursor - 1);
+      }
+      endMoveRows();
+    }
+    cursor -= length;
+  }
+  cursor = row;
+  for (const MPDQueueRange::Range &range : ranges) {
+    if (range.first < row) continue;
+    const qint32 length = range.second - range.first;
+    if (range.first != cursor) {
+      beginMoveRows(QModelIndex(), range.first, range.second - 1,
+                    QModelIndex(), cursor);
+      for (qint32 moved = 0; moved < length; moved++) {
+        playlistQueue_.move(range.first + moved, cursor + moved);
+      }
+      endMoveRows();
+    }
+    cursor += length;
+  }
+}
+
+void CurrentPlaylistModel::prioritizeSongsAt(const QList<qint32> &rows,
+                                             const quint8 priority) {
+  // nothing shown changes
+  if (!rows.isEmpty()) emit prioritizeSongs(rows, priority);
+}
+
+void CurrentPlaylistModel::resize(const quint32 version,
+                                  const quint32 length,
+                                  const quint32 firstChanged) {
+  if (!virtual_) {
+    beginResetModel();
+    playlistQueue_.clear();
+    virtual_ = true;
+    version_ = version;
+    length_ = static_cast<int>(length);
+    pages_.clear();
+    pendingPages_.clear();
+    endResetModel();
+    return;
+  }
+
+  // Rows are only added or removed at the end. The pages from the one
+  // holding the first changed row on are shown anew as they are fetched
+  // again, the replies pending are for the old version.
+  const int newLength = static_cast<int>(length);
+  const int first = static_cast<int>(qMin(firstChanged, length));
+  const int changedEnd = qMin(length_, newLength);
+  for (const int page : pages_.keys()) {
+    if ((page + 1) * pageSize_ > first) pages_.remove(page);
+  }
+  pendingPages_.clear();
+  version_ = version;
+  if (newLength > length_) {
+    beginInsertRows(QModelIndex(), length_, newLength - 1);
+    length_ = newLength;
+    endInsertRows();
+  } else if (newLength < length_) {
+    beginRemoveRows(QModelIndex(), newLength, length_ - 1);
+    length_ = newLength;
+    endRemoveRows();
+  }
+  if (first < changedEnd) {
+    emit dataChanged(index(first), index(changedEnd - 1));
+  }
+}
+
+void CurrentPlaylistModel::rangeFetched(const quint32 version,
+                                        const quint32 start,
+                                        const MPDPlaylistSnapshot &songs) {
+  // Rows of another version are fetched again once shown, after the
+  // resize to it, which also forgot the requests pending. A reply of an
+  // old version must not clear the mark of a page requested since.
+  if (!virtual_ || version != version_) return;
+  const int page = static_cast<int>(start) / pageSize_;
+  pendingPages_.remove(page);
+  if (songs->isEmpty()) return;
+
+  pages_.insert(page, new QList<MPDSongMetadata>(*songs));
+  const int first = page * pageSize_;
+  const int last = qMin(first + songs->size(), length_) - 1;
+  if (last >= first) emit dataChanged(index(first), index(last));
+}
+
+const MPDSongMetadata *CurrentPlaylistModel::song(const int row) const {
+  if (!virtual_) return &playlistQueue_.at(row);
+
+  const int page = row / pageSize_;
+  const QList<MPDSongMetadata> *songs = pages_.object(page);
+  if (!songs) {
+    requestPage(page);
+    return nullptr;
+  }
+  const int offset = row % pageSize_;
+  return offset < songs->size() ? &songs->at(offset) : nullptr;
+}
+
+void CurrentPlaylistModel::requestPage(const int page) const {
+  fetchPage(page);
+  // prefetch ahead of the scrolling
+  const int next = page >= lastPage_ ? page + 1 : page - 1;
+  lastPage_ = page;
+  if (next >= 0 && next * pageSize_ < length_ && !pages_.contains(next)) {
+    fetchPage(next);
+  }
+}
+
+void CurrentPlaylistModel::fetchPage(const int page) const {
+  if (pendingPages_.contains(page)) return;
+  pendingPages_.insert(page);
+  const int start = page * pageSize_;
+  // the views only hold a const model while they paint
+  emit const_cast<CurrentPlaylistModel *>(this)->rangeRequested(
+      static_cast<quint32>(start),
+      static_cast<quint32>(qMin(start + pageSize_, length_)));
+}
+
 void CurrentPlaylistModel::doubleClicked(QModelIndex index) {
   // invalid index
   if (!index.isValid()) return;
   // out of bound row value
-  if (index.row() >= playlistQueue_->size()) return;
+  if (index.row() >= rowCount()) return;
 
-  const uint position = playlistQueue_->at(index.row())->pos;
-  emit playSong(position);
+  emit playSong(static_cast<quint32>(index.row()));
 }
@@ -2,35 +2,92 @@
 #define CURRENTPLAYLISTMODEL_H
 
 #include <QAbstractListModel>
+#include <QCache>
+#include <QPair>
+#include <QSet>
+#include <QVector>
 
 #include "../lib/mpdmodel.h"
 
 class CurrentPlaylistModel : public QAbstractListModel {
   Q_OBJECT
  public:
-  explicit CurrentPlaylistModel(
-      QList<MPDSongMetadata *> *playlistQueue = nullptr,
-      QObject *parent = nullptr);
+  explicit CurrentPlaylistModel(QObject *parent = nullptr);
   ~CurrentPlaylistModel();
   QVariant headerData(int section, Qt::Orientation orientation,
                       int role = Qt::DisplayRole) const;
   int rowCount(const QModelIndex &parent = QModelIndex()) const;
   QVariant data(const QModelIndex &index, int role) const;
+  Qt::ItemFlags flags(const QModelIndex &index) const;
+  QStringList mimeTypes() const;
+  QMimeData *mimeData(const QModelIndexList &indexes) const;
+  Qt::DropActions supportedDropActions() const;
+  bool dropMimeData(const QMimeData *data, Qt::DropAction action, int row,
+                    int column, const QModelIndex &parent);
   void updateCurrentSong(quint32 id);
   qint32 getRowId(qint32 row) const;
   qint32 getRowPos(qint32 row) const;
   qint32 songIdToRow(qint32 id) const;
   qint32 getCurrentSongId() const { return song_id; }
 
+  // Edit the rows right away & ask for MPD's queue to be edited alike, the
+  // changes MPD then reports fit the rows as they are now
+  void removeSongsAt(const QList<qint32> &rows);
+  // Moves the rows in their order in front of row, to the end if row is
+  // the row count
+  void moveSongsTo(const QList<qint32> &rows, qint32 row);
+  void prioritizeSongsAt(const QList<qint32> &rows, quint8 priority);
+
  signals:
   void playSong(quint32 song);
+  // position is -1 when the songs should be appended to the queue
+  void addSongs(const QStringList &filenames, qint32 position);
+  void removeSongs(const QList<qint32> &positions);
+  void moveSongs(const QList<qint32> &positions, qint32 to);
+  void prioritizeSongs(const QList<qint32> &positions, quint8 priority);
+  // a virtual queue needs the songs at positions start up to end
+  void rangeRequested(quint32 start, quint32 end);
+  // the changes did not fit the rows held, the whole queue is needed
+  void outOfStep();
 
  public slots:
-  void updateModel();
+  void updateModel(const MPDPlaylistSnapshot &playlistQueue);
+  // Applies the changes in place, with the row signals of each insert, move
+  // & removal, so views keep their selection & scroll position
+  void applyChanges(const MPDQueueChangesSnapshot &changes);
+  // Switches to a virtual queue of length rows or updates it. Only the
+  // pages of rows being shown are held, the least recently shown ones are
+  // dropped, so the memory used does not grow with the queue. Those before
+  // firstChanged are kept on an update.
+  void resize(quint32 version, quint32 length, quint32 firstChanged);
+  void rangeFetched(quint32 version, quint32 start,
+                    const MPDPlaylistSnapshot &songs);
   void doubleClicked(QModelIndex index);
 
  private:
-  const QList<MPDSongMetadata *> *playlistQueue_;
+  // The song in row or nullptr if its page still has to be fetched
+  const MPDSongMetadata *song(int row) const;
+  // Fetches the page & the next one in the direction the view scrolls
+  void requestPage(int page) const;
+  void fetchPage(int page) const;
+  // The moves, each as a row & the row it goes to, that reorder the rows
+  // into the ids of the positions, false if more than maxMoves_
+  bool planMoves(const QVector<qint32> &ids,
+                 QVector<QPair<int, int>> *moves) const;
+
+  // kept in step with MPD's queue, a song's row is its position
+  QList<MPDSongMetadata> playlistQueue_;
+  // a virtual queue only holds some of its pages, by page number
+  bool virtual_;
+  quint32 version_;
+  int length_;
+  mutable QCache<int, QList<MPDSongMetadata>> pages_;
+  mutable QSet<int> pendingPages_;
+  mutable int lastPage_;
+  static const int pageSize_;
+  static const int maxPages_;
+  // moves applyChanges() shows one by one, a reset beyond
+  static const int maxMoves_;
   qint32 song_id;
   qint32 lastsong_id;
 };
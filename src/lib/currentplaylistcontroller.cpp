@@ -1,7 +1,19 @@
 #include "currentplaylistcontroller.h"
+#include "mpdqueuerange.h"
 #include "mpdsocket.h"
 
+// https://www.musicpd.org/doc/protocol/queue.html
 const QByteArray CurrentPlaylistController::clearCmd = "clear";
+const QByteArray CurrentPlaylistController::addCmd = "add";
+const QByteArray CurrentPlaylistController::addIdCmd = "addid";
+const QByteArray CurrentPlaylistController::deleteCmd = "delete";
+const QByteArray CurrentPlaylistController::moveCmd = "move";
+const QByteArray CurrentPlaylistController::prioCmd = "prio";
+
+static QByteArray rangeArgument(const MPDQueueRange::Range &range) {
+  return QByteArray::number(range.first) + ':' +
+         QByteArray::number(range.second);
+}
 
 CurrentPlaylistController::CurrentPlaylistController(
     QObject *parent, std::shared_ptr<MPDSocket> mpdSocket)
@@ -9,6 +21,81 @@ CurrentPlaylistController::CurrentPlaylistController(
 
 CurrentPlaylistController::~CurrentPlaylistController() {}
 
-bool CurrentPlaylistController::clear() const {
-  return mpdSocket_->sendCommand(clearCmd).second;
+void CurrentPlaylistController::clear(
+    const MPDResponseHandler &handler) const {
+  mpdSocket_->sendCommand(clearCmd, handler);
+}
+
+void CurrentPlaylistController::add(
+    const QStringList &uris, qint32 position,
+    const MPDCommandListHandler &handler) const {
+  MPDCommandList commandList(mpdSocket_);
+  for (int i = 0; i < uris.size(); i++) {
+    if (position < 0) {
+      commandList.add(addCmd + " " + MPDCommandList::quote(uris.at(i)));
+    } else {
+      commandList.add(addIdCmd + " " + MPDCommandList::quote(uris.at(i)) +
+                      " " + QByteArray::number(position + i));
+    }
+  }
+  commandList.send(handler);
+}
+
+void CurrentPlaylistController::remove(
+    const QList<qint32> &positions,
+    const MPDCommandListHandler &handler) const {
+  // the last range first, the positions before it stay as they are
+  const QList<MPDQueueRange::Range> positionRanges =
+      MPDQueueRange::ranges(positions);
+  MPDCommandList commandList(mpdSocket_);
+  for (int i = positionRanges.size() - 1; i >= 0; i--) {
+    commandList.add(deleteCmd + " " + rangeArgument(positionRanges.at(i)));
+  }
+  commandList.send(handler);
+}
+
+void CurrentPlaylistController::move(
+    const QList<qint32> &positions, const qint32 to,
+    const MPDCommandListHandler &handler) const {
+  // Ranges before to are moved in front of the ones already moved, the last
+  // one first, which leaves the positions of the others as they are. Those
+  // after to are then moved behind them, the first one first. The target
+  // position is the one after the range is taken out.
+  const QList<MPDQueueRange::Range> positionRanges =
+      MPDQueueRange::ranges(positions, to);
+  MPDCommandList commandList(mpdSocket_);
+  qint32 cursor = to;
+  for (int i = positionRanges.size() - 1; i >= 0; i--) {
+    const MPDQueueRange::Range &range = positionRanges.at(i);
+    if (range.first >= to) continue;
+    const qint32 length = range.second - range.first;
+    // unless it is in front of them already
+    if (range.second != cursor) {
+      commandList.add(moveCmd + " " + rangeArgument(range) + " " +
+                      QByteArray::number(cursor - length));
+    }
+    cursor -= length;
+  }
+  cursor = to;
+  for (const MPDQueueRange::Range &range : positionRanges) {
+    if (range.first < to) continue;
+    if (range.first != cursor) {
+      commandList.add(moveCmd + " " + rangeArgument(range) + " " +
+                      QByteArray::number(cursor));
+    }
+    cursor += range.second - range.first;
+  }
+  commandList.send(handler);
+}
+
+void CurrentPlaylistController::prioritize(
+    const QList<qint32> &positions, const quint8 priority,
+    const MPDCommandListHandler &handler) const {
+  MPDCommandList commandList(mpdSocket_);
+  for (const MPDQueueRange::Range &range :
+       MPDQueueRange::ranges(positions)) {
+    commandList.add(prioCmd + " " + QByteArray::number(priority) + " " +
+                    rangeArgument(range));
+  }
+  commandList.send(handler);
 }
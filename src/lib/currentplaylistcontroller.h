@@ -1,10 +1,13 @@
 #ifndef CURRENTPLAYLISTCONTROLLER_H
 #define CURRENTPLAYLISTCONTROLLER_H
 
+#include <QList>
 #include <QObject>
+#include <QStringList>
 #include <memory>
 
-class MPDSocket;
+#include "mpdcommandlist.h"
+#include "mpdsocket.h"
 
 class CurrentPlaylistController : QObject {
   Q_OBJECT
@@ -14,11 +17,37 @@ class CurrentPlaylistController : QObject {
   ~CurrentPlaylistController();
 
 public slots:
-  bool clear() const;
+  void clear(
+      const MPDResponseHandler &handler = MPDResponseHandler()) const;
+  // Adds all uris in a single command list. With a position >= 0 the songs
+  // are inserted there in order, otherwise they are appended.
+  void add(const QStringList &uris, qint32 position = -1,
+           const MPDCommandListHandler &handler = MPDCommandListHandler())
+      const;
+  // The edits below take the positions of the songs in any order, each run
+  // of consecutive positions costs a single command & all of them are sent
+  // in one command list.
+  void remove(const QList<qint32> &positions,
+              const MPDCommandListHandler &handler = MPDCommandListHandler())
+      const;
+  // Moves the songs in their order before the song at position to (after
+  // the last one if to is the queue length)
+  void move(const QList<qint32> &positions, qint32 to,
+            const MPDCommandListHandler &handler = MPDCommandListHandler())
+      const;
+  // Songs with a higher priority (0 - 255) are played first in random mode
+  void prioritize(
+      const QList<qint32> &positions, quint8 priority,
+      const MPDCommandListHandler &handler = MPDCommandListHandler()) const;
 
 private:
   std::shared_ptr<MPDSocket> mpdSocket_;
   const static QByteArray clearCmd;
+  const static QByteArray addCmd;
+  const static QByteArray addIdCmd;
+  const static QByteArray deleteCmd;
+  const static QByteArray moveCmd;
+  const static QByteArray prioCmd;
 };
 
 #endif  // CURRENTPLAYLISTCONTROLLER_H
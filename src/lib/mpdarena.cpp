@@ -0,0 +1,64 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "mpdarena.h"
+
+#include <cstdlib>
+
+const size_t MPDArena::blockSize_ = 64 * 1024;
+
+MPDArena::MPDArena() : current_(nullptr), remaining_(0) {}
+
+MPDArena::~MPDArena() {
+  clear();
+  for (char *block : blocks_) std::free(block);
+}
+
+void MPDArena::clear() {
+  // children are destroyed before the parents they were created by
+  for (int i = destructors_.size() - 1; i >= 0; i--) {
+    destructors_.at(i).destroy(destructors_.at(i).object);
+  }
+  destructors_.clear();
+
+  if (blocks_.isEmpty()) return;
+  for (int i = 1; i < blocks_.size(); i++) std::free(blocks_.at(i));
+  blocks_.resize(1);
+  current_ = blocks_.first();
+  remaining_ = blockSize_;
+}
+
+void *MPDArena::allocate(const size_t size, const size_t alignment) {
+  const size_t padding =
+      (alignment - reinterpret_cast<size_t>(current_) % alignment) %
+      alignment;
+  if (!current_ || padding + size > remaining_) {
+    // objects larger than a block get one of their own
+    const size_t blockSize = qMax(blockSize_, size + alignment);
+    char *block = static_cast<char *>(std::malloc(blockSize));
+    if (!block) throw std::bad_alloc();
+    blocks_.append(block);
+    current_ = block;
+    remaining_ = blockSize;
+    return allocate(size, alignment);
+  }
+
+  char *const object = current_ + padding;
+  current_ = object + size;
+  remaining_ -= padding + size;
+  return object;
+}
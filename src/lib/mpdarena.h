@@ -0,0 +1,67 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MPDARENA_H
+#define MPDARENA_H
+
+#include <QVector>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Allocates objects back to back in large blocks & destroys them all at
+// once, for the many small nodes of a tree that live & die together.
+class MPDArena {
+ public:
+  MPDArena();
+  ~MPDArena();
+
+  template <typename T, typename... Args>
+  T *create(Args &&... args) {
+    T *object = new (allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+    if (!std::is_trivially_destructible<T>::value) {
+      destructors_.append(Destructor{object, &destroy<T>});
+    }
+    return object;
+  }
+  // Destroys every object created so far, the first block is kept
+  void clear();
+
+ private:
+  Q_DISABLE_COPY(MPDArena)
+
+  struct Destructor {
+    void *object;
+    void (*destroy)(void *);
+  };
+
+  template <typename T>
+  static void destroy(void *object) {
+    static_cast<T *>(object)->~T();
+  }
+
+  void *allocate(const size_t size, const size_t alignment);
+
+  QVector<char *> blocks_;
+  char *current_;
+  size_t remaining_;
+  QVector<Destructor> destructors_;
+  static const size_t blockSize_;
+};
+
+#endif  // MPDARENA_H
@@ -15,35 +15,172 @@
 */
 
 #include "mpdclient.h"
+#include "currentplaylistcontroller.h"
+#include "mpdconnectionpool.h"
 #include "mpddata.h"
 #include "mpdmodel.h"
 #include "mpdsocket.h"
 #include "playbackcontroller.h"
 #include "playbackoptionscontroller.h"
 
+#include <QDebug>
+#include <QSettings>
+#include <QThread>
+
+const int MPDClient::reconnectBaseDelay_ = 1000;
+const int MPDClient::reconnectMaxDelay_ = 60000;
+
+static int bulkConnectionCount() {
+  QSettings settings;
+  settings.beginGroup("mpd-server-connection");
+  const int bulkConnections = settings.value("bulk-connections", 1).toInt();
+  settings.endGroup();
+  return bulkConnections;
+}
+
+// Everything that is passed between the MPD & the GUI thread in queued
+// signals or calls.
+static void registerMetaTypes() {
+  qRegisterMetaType<MPDResponseHandler>();
+  qRegisterMetaType<MPDChunkHandler>();
+  qRegisterMetaType<MPDStatusSnapshot>();
+  qRegisterMetaType<MPDStatsSnapshot>();
+  qRegisterMetaType<MPDSongSnapshot>();
+  qRegisterMetaType<MPDPlaylistSnapshot>();
+  qRegisterMetaType<MPDQueueChangesSnapshot>();
+  qRegisterMetaType<std::shared_ptr<RootItem>>();
+  qRegisterMetaType<MusicLibraryItemRoot *>();
+  qRegisterMetaType<MPDLibrarySnapshot>();
+  qRegisterMetaType<MPDLibraryCache::Order>();
+  qRegisterMetaType<QList<MPDSongMetadata>>();
+  qRegisterMetaType<QList<MPDConnectionHealth>>();
+  qRegisterMetaType<MPDClient::ConnectionState>();
+}
+
 MPDClient::MPDClient(QObject *parent)
     : QObject(parent),
-      mpdSocket_(new MPDSocket(this)),
-      dataAccess_(new MPDdata(this, mpdSocket_)),
+      connectionPool_(new MPDConnectionPool(this, bulkConnectionCount())),
+      mpdSocket_(
+          connectionPool_->socket(MPDConnectionPool::Role::Interactive)),
+      idleListener_(new MPDIdleListener(
+          this, connectionPool_->socket(MPDConnectionPool::Role::Idle))),
+      dataAccess_(new MPDdata(this, connectionPool_)),
       playbackCtrlr_(new PlaybackController(this, mpdSocket_)),
-      playbackOptionsCtrlr_(new PlaybackOptionsController(this, mpdSocket_)) {
+      playbackOptionsCtrlr_(new PlaybackOptionsController(this, mpdSocket_)),
+      currentPlaylistCtrlr_(new CurrentPlaylistController(this, mpdSocket_)),
+      port_(0),
+      connectionState_(ConnectionState::Disconnected),
+      reconnectTimer_(this),
+      reconnectAttempt_(0),
+      random_(std::random_device()()) {
+  registerMetaTypes();
+
   // signal forwarding
-  connect(mpdSocket_.get(), &MPDSocket::commandsent, this,
+  connect(connectionPool_.get(), &MPDConnectionPool::commandsent, this,
           &MPDClient::commandsent);
-  connect(this, &MPDClient::sendcommand,
+  connect(connectionPool_.get(), &MPDConnectionPool::healthChanged, this,
+          [this]() { emit connectionHealthChanged(connectionHealth()); });
+  connect(this, &MPDClient::sendcommand, this,
           [=](const QByteArray command) { mpdSocket_->sendCommand(command); });
+  connect(idleListener_.get(), &MPDIdleListener::changed, this,
+          &MPDClient::idleChanged);
+  connect(idleListener_.get(), &MPDIdleListener::unavailable, this,
+          &MPDClient::idleUnavailable);
+  connect(idleListener_.get(), &MPDIdleListener::changed, dataAccess_.get(),
+          &MPDdata::update);
+
+  reconnectTimer_.setSingleShot(true);
+  connect(&reconnectTimer_, &QTimer::timeout, this, &MPDClient::reconnect);
+  connect(mpdSocket_.get(), &MPDSocket::healthChanged, this,
+          &MPDClient::onInteractiveHealthChanged);
 }
 
 MPDClient::~MPDClient() {}
 
 bool MPDClient::connectToHost(const QString &hostName, const quint16 port,
                               const QString &password) {
-  mpdSocket_->connectToMPDHost(hostName, port, password);
-  return mpdSocket_->isConnected();
+  if (thread() != QThread::currentThread()) {
+    bool connected = false;
+    QMetaObject::invokeMethod(
+        this, "connectToHost", Qt::BlockingQueuedConnection,
+        Q_RETURN_ARG(bool, connected), Q_ARG(QString, hostName),
+        Q_ARG(quint16, port), Q_ARG(QString, password));
+    return connected;
+  }
+
+  hostname_ = hostName;
+  port_ = port;
+  passwd_ = password;
+  reconnectTimer_.stop();
+  if (!connectionPool_->connectToHost(hostname_, port_, passwd_)) return false;
+
+  reconnectAttempt_ = 0;
+  setConnectionState(ConnectionState::Connected);
+  idleListener_->start();
+  return true;
 }
 
-void MPDClient::disconnectFromHost() const {
-  mpdSocket_->disconnectFromMPDHost();
+void MPDClient::disconnectFromHost() {
+  if (thread() != QThread::currentThread()) {
+    QMetaObject::invokeMethod(this, "disconnectFromHost",
+                              Qt::QueuedConnection);
+    return;
+  }
+
+  // set first, the sockets going down must not trigger a reconnect
+  setConnectionState(ConnectionState::Disconnected);
+  reconnectTimer_.stop();
+  idleListener_->stop();
+  connectionPool_->disconnectFromHost();
+}
+
+void MPDClient::onInteractiveHealthChanged(const bool healthy) {
+  // a timed out reply closes the socket too, so this covers both
+  if (healthy || mpdSocket_->isConnected() ||
+      connectionState_ != ConnectionState::Connected) {
+    return;
+  }
+
+  qWarning() << "MPD connection lost, reconnecting";
+  idleListener_->stop();
+  setConnectionState(ConnectionState::Reconnecting);
+  scheduleReconnect();
+}
+
+void MPDClient::reconnect() {
+  if (connectionState_ != ConnectionState::Reconnecting) return;
+
+  // the sockets that survived are kept, only lost ones are reconnected
+  if (!connectionPool_->connectToHost(hostname_, port_, passwd_)) {
+    scheduleReconnect();
+    return;
+  }
+
+  qInfo() << "MPD connection reestablished after" << reconnectAttempt_
+          << "attempt(s)";
+  reconnectAttempt_ = 0;
+  setConnectionState(ConnectionState::Connected);
+  idleListener_->start();
+  dataAccess_->resync();
+}
+
+void MPDClient::scheduleReconnect() {
+  // exponential backoff with jitter, so a restarted MPD isn't hit by all
+  // its clients at the same moment
+  const int shift = qMin(reconnectAttempt_, 16);
+  const int delay =
+      qMin(reconnectMaxDelay_, reconnectBaseDelay_ * (1 << shift));
+  std::uniform_int_distribution<int> jitter(delay / 2, delay);
+  reconnectAttempt_++;
+  reconnectTimer_.start(jitter(random_));
+  qInfo() << "reconnect attempt" << reconnectAttempt_ << "in"
+          << reconnectTimer_.interval() << "ms";
+}
+
+void MPDClient::setConnectionState(const ConnectionState state) {
+  if (connectionState_ == state) return;
+  connectionState_ = state;
+  emit connectionStateChanged(connectionState_);
 }
 
 std::shared_ptr<MPDdata> MPDClient::getSharedMPDdataPtr() const {
@@ -59,3 +196,18 @@ std::shared_ptr<PlaybackOptionsController>
 MPDClient::getSharedPlaybackOptionsControllerPtr() const {
   return playbackOptionsCtrlr_;
 }
+
+std::shared_ptr<CurrentPlaylistController>
+MPDClient::getSharedCurrentPlaylistControllerPtr() const {
+  return currentPlaylistCtrlr_;
+}
+
+MPDCommandList MPDClient::createCommandList() const {
+  return MPDCommandList(mpdSocket_);
+}
+
+bool MPDClient::isIdleActive() const { return idleListener_->isActive(); }
+
+QList<MPDConnectionHealth> MPDClient::connectionHealth() const {
+  return connectionPool_->health();
+}
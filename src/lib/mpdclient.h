@@ -18,41 +18,103 @@
 #define MPDCLIENT_H
 
 #include <QObject>
+#include <QTimer>
+#include <atomic>
 #include <memory>
+#include <random>
+
+#include "mpdcommandlist.h"
+#include "mpdconnectionpool.h"
+#include "mpdidlelistener.h"
 
 class MPDSocket;
 class CommandController;
+class CurrentPlaylistController;
 class MPDdata;
 class PlaybackController;
 class PlaybackOptionsController;
 
+// Meant to live in a thread of its own together with everything it owns, so
+// neither network waits nor parsing ever stall the GUI. The controllers &
+// MPDdata may be used from the GUI thread, their work is queued to ours.
 class MPDClient : public QObject {
   Q_OBJECT
 
  public:
+  enum class ConnectionState {
+    Disconnected,
+    Connected,
+    // connection lost, retrying with backoff until disconnectFromHost()
+    Reconnecting,
+  };
+
   MPDClient(QObject *parent = nullptr);
   ~MPDClient();
 
-  bool connectToHost(const QString &hostName, const quint16 port,
-                     const QString &password);
-  void disconnectFromHost() const;
+  // Blocks until the handshake is done, also when called from another thread
+  Q_INVOKABLE bool connectToHost(const QString &hostName, const quint16 port,
+                                 const QString &password);
+  Q_INVOKABLE void disconnectFromHost();
+  ConnectionState connectionState() const { return connectionState_; }
 
   std::shared_ptr<MPDdata> getSharedMPDdataPtr() const;
   std::shared_ptr<PlaybackController> getSharedPlaybackControllerPtr() const;
   std::shared_ptr<PlaybackOptionsController>
   getSharedPlaybackOptionsControllerPtr() const;
+  std::shared_ptr<CurrentPlaylistController>
+  getSharedCurrentPlaylistControllerPtr() const;
+
+  // Batches arbitrary commands (e.g. several controller calls) into a single
+  // round trip.
+  MPDCommandList createCommandList() const;
+
+  // true while state changes are pushed through idle, false when the
+  // caller has to poll the status itself
+  bool isIdleActive() const;
+  // only safe to call from the MPD thread, the GUI gets the health passed
+  // with connectionHealthChanged()
+  QList<MPDConnectionHealth> connectionHealth() const;
 
  signals:
   void commandsent(QString command, QByteArray result);
   void sendcommand(const QByteArray command);
+  void idleChanged(MPDIdleListener::Subsystems subsystems);
+  void idleUnavailable();
+  void connectionHealthChanged(QList<MPDConnectionHealth> health);
+  void connectionStateChanged(ConnectionState state);
+
+ private slots:
+  void onInteractiveHealthChanged(const bool healthy);
+  void reconnect();
 
  private:
+  std::shared_ptr<MPDConnectionPool> connectionPool_;
+  // the interactive connection of the pool
   std::shared_ptr<MPDSocket> mpdSocket_;
+  std::shared_ptr<MPDIdleListener> idleListener_;
 
  public:
   std::shared_ptr<MPDdata> dataAccess_;
   std::shared_ptr<PlaybackController> playbackCtrlr_;
   std::shared_ptr<PlaybackOptionsController> playbackOptionsCtrlr_;
+  std::shared_ptr<CurrentPlaylistController> currentPlaylistCtrlr_;
+
+ private:
+  QString hostname_;
+  quint16 port_;
+  QString passwd_;
+  // read from the GUI thread as well
+  std::atomic<ConnectionState> connectionState_;
+  QTimer reconnectTimer_;
+  int reconnectAttempt_;
+  std::minstd_rand random_;
+  static const int reconnectBaseDelay_;
+  static const int reconnectMaxDelay_;
+
+  void setConnectionState(const ConnectionState state);
+  void scheduleReconnect();
 };
 
+Q_DECLARE_METATYPE(MPDClient::ConnectionState)
+
 #endif  // MPDCLIENT_H
@@ -0,0 +1,140 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mpdcommandlist.h"
+#include "mpdsocket.h"
+
+#include <QDebug>
+
+static const QByteArray listOkResponse("list_OK");
+static const QByteArray ackResponse("ACK");
+static const QByteArray commandListOkBeginCmd("command_list_ok_begin");
+static const QByteArray commandListEndCmd("command_list_end");
+
+// MPD rejects command lists bigger than max_command_list_size (2048 KiB by
+// default), stay well below that.
+static const int maxBlockSize = 1024 * 1024;
+
+namespace {
+struct CommandListState {
+  std::shared_ptr<MPDSocket> mpdSocket;
+  QList<QByteArray> commands;
+  int nextCommand;
+  QList<QPair<QByteArray, bool>> results;
+  MPDCommandListHandler handler;
+};
+
+// "ACK [error@command_listNum] {current_command} message_text"
+int ackCommandIndex(const QByteArray &ackLine) {
+  const int at = ackLine.indexOf('@');
+  const int end = ackLine.indexOf(']', at);
+  if (at == -1 || end == -1) return -1;
+  bool ok = false;
+  const int index = ackLine.mid(at + 1, end - at - 1).toInt(&ok);
+  return ok ? index : -1;
+}
+
+// Splits the reply of one block at its list_OK lines. Returns the index
+// (inside the block) of the command that failed or -1.
+int splitReply(const QByteArray &reply,
+               QList<QPair<QByteArray, bool>> *results) {
+  const int firstResult = results->size();
+  int segmentStart = 0;
+  int lineStart = 0;
+  int lineEnd = 0;
+  while ((lineEnd = reply.indexOf('\n', lineStart)) != -1) {
+    const QByteArray line = QByteArray::fromRawData(
+        reply.constData() + lineStart, lineEnd - lineStart);
+    const int nextLine = lineEnd + 1;
+    if (line == listOkResponse) {
+      results->append(qMakePair(
+          reply.mid(segmentStart, lineStart - segmentStart), true));
+      segmentStart = nextLine;
+    } else if (line.startsWith(ackResponse)) {
+      results->append(
+          qMakePair(reply.mid(segmentStart, nextLine - segmentStart), false));
+      const int index = ackCommandIndex(line);
+      return index != -1 ? index : results->size() - firstResult - 1;
+    }
+    lineStart = nextLine;
+  }
+  return -1;
+}
+
+void sendNextBlock(const std::shared_ptr<CommandListState> &state) {
+  const int blockStart = state->nextCommand;
+  QByteArray block(commandListOkBeginCmd);
+  block += '\n';
+  // always take at least one command, even if it alone exceeds the limit
+  do {
+    block += state->commands.at(state->nextCommand++);
+    block += '\n';
+  } while (state->nextCommand < state->commands.size() &&
+           block.size() + state->commands.at(state->nextCommand).size() <
+               maxBlockSize);
+  block += commandListEndCmd;
+
+  state->mpdSocket->sendCommand(
+      block, [=](const QPair<QByteArray, bool> &reply) {
+        const int failed = splitReply(reply.first, &state->results);
+        if (failed != -1 || !reply.second) {
+          // without an ACK the connection failed, nothing after the
+          // results we already have was executed
+          const int failedIndex =
+              failed != -1 ? blockStart + failed : state->results.size();
+          qWarning() << "command list failed at command" << failedIndex;
+          if (state->handler) state->handler(state->results, failedIndex);
+          return;
+        }
+        if (state->nextCommand < state->commands.size()) {
+          sendNextBlock(state);
+        } else if (state->handler) {
+          state->handler(state->results, -1);
+        }
+      });
+}
+}  // namespace
+
+MPDCommandList::MPDCommandList(std::shared_ptr<MPDSocket> mpdSocket)
+    : mpdSocket_(mpdSocket) {}
+
+MPDCommandList &MPDCommandList::add(const QByteArray &command) {
+  commands_.append(command);
+  return *this;
+}
+
+void MPDCommandList::clear() { commands_.clear(); }
+
+void MPDCommandList::send(const MPDCommandListHandler &handler) {
+  if (commands_.isEmpty()) {
+    if (handler) handler(QList<QPair<QByteArray, bool>>(), -1);
+    return;
+  }
+
+  std::shared_ptr<CommandListState> state(new CommandListState);
+  state->mpdSocket = mpdSocket_;
+  state->commands.swap(commands_);
+  state->nextCommand = 0;
+  state->handler = handler;
+  sendNextBlock(state);
+}
+
+QByteArray MPDCommandList::quote(const QString &argument) {
+  QByteArray quoted = argument.toUtf8();
+  quoted.replace('\\', "\\\\");
+  quoted.replace('"', "\\\"");
+  return '"' + quoted + '"';
+}
@@ -0,0 +1,60 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MPDCOMMANDLIST_H
+#define MPDCOMMANDLIST_H
+
+#include <QByteArray>
+#include <QList>
+#include <QPair>
+#include <functional>
+#include <memory>
+
+class MPDSocket;
+
+// Receives one reply per executed command. failedIndex is the position of
+// the command MPD rejected (its ACK line is the last result) or -1 if every
+// command succeeded.
+typedef std::function<void(const QList<QPair<QByteArray, bool>> &results,
+                           int failedIndex)>
+    MPDCommandListHandler;
+
+// Collects commands & sends them as command_list_ok_begin ... command_list_end
+// blocks, so a bulk operation costs one round trip instead of one per command.
+// https://www.musicpd.org/doc/protocol/command_lists.html
+class MPDCommandList {
+ public:
+  explicit MPDCommandList(std::shared_ptr<MPDSocket> mpdSocket = nullptr);
+
+  MPDCommandList &add(const QByteArray &command);
+  inline int size() const { return commands_.size(); }
+  inline bool isEmpty() const { return commands_.isEmpty(); }
+  void clear();
+
+  // Sends the collected commands & clears the list. Lists larger than MPD's
+  // max_command_list_size are split into consecutive blocks, a block is only
+  // sent once the previous one succeeded.
+  void send(const MPDCommandListHandler &handler = MPDCommandListHandler());
+
+  // Quotes & escapes a command argument (e.g. an uri with spaces).
+  static QByteArray quote(const QString &argument);
+
+ private:
+  std::shared_ptr<MPDSocket> mpdSocket_;
+  QList<QByteArray> commands_;
+};
+
+#endif  // MPDCOMMANDLIST_H
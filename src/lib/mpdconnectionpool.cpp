@@ -0,0 +1,125 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mpdconnectionpool.h"
+#include "mpdsocket.h"
+
+#include <QDebug>
+
+MPDConnectionPool::MPDConnectionPool(QObject *parent,
+                                     const int bulkConnections)
+    : QObject(parent),
+      interactiveSocket_(new MPDSocket(this)),
+      idleSocket_(new MPDSocket(this)) {
+  interactiveSocket_->setObjectName("interactive");
+  idleSocket_->setObjectName("idle");
+  // an idle reply may take forever, dead peers are detected by keepalive
+  idleSocket_->setResponseTimeoutEnabled(false);
+  idleSocket_->setKeepAliveEnabled(true);
+
+  for (int i = 0; i < qMax(1, bulkConnections); i++) {
+    std::shared_ptr<MPDSocket> bulkSocket(new MPDSocket(this));
+    bulkSocket->setObjectName("bulk-" + QString::number(i));
+    bulkSockets_ << bulkSocket;
+  }
+
+  // the idle connection is left out, it would only echo idle replies
+  QList<std::shared_ptr<MPDSocket>> sockets(bulkSockets_);
+  sockets << interactiveSocket_;
+  for (const std::shared_ptr<MPDSocket> &mpdSocket : sockets) {
+    connect(mpdSocket.get(), &MPDSocket::commandsent, this,
+            &MPDConnectionPool::commandsent);
+  }
+  sockets << idleSocket_;
+  for (const std::shared_ptr<MPDSocket> &mpdSocket : sockets) {
+    connect(mpdSocket.get(), &MPDSocket::healthChanged, this,
+            &MPDConnectionPool::healthChanged);
+  }
+}
+
+MPDConnectionPool::~MPDConnectionPool() {}
+
+bool MPDConnectionPool::connectToHost(const QString &hostName,
+                                      const quint16 port,
+                                      const QString &password) {
+  // connections that are still up are kept, e.g. when reconnecting
+  if (!interactiveSocket_->isConnected()) {
+    interactiveSocket_->connectToMPDHost(hostName, port, password);
+    if (!interactiveSocket_->isConnected()) return false;
+  }
+
+  if (!idleSocket_->isConnected()) {
+    idleSocket_->connectToMPDHost(hostName, port, password);
+  }
+
+  for (const std::shared_ptr<MPDSocket> &bulkSocket : bulkSockets_) {
+    if (bulkSocket->isConnected()) continue;
+    bulkSocket->connectToMPDHost(hostName, port, password);
+    if (!bulkSocket->isConnected()) {
+      qWarning() << "bulk connection" << bulkSocket->objectName()
+                 << "failed, using the remaining connections";
+    }
+  }
+  return true;
+}
+
+void MPDConnectionPool::disconnectFromHost() {
+  for (const std::shared_ptr<MPDSocket> &bulkSocket : bulkSockets_) {
+    bulkSocket->disconnectFromMPDHost();
+  }
+  idleSocket_->disconnectFromMPDHost();
+  interactiveSocket_->disconnectFromMPDHost();
+}
+
+std::shared_ptr<MPDSocket> MPDConnectionPool::socket(const Role role) const {
+  switch (role) {
+    case Role::Interactive:
+      return interactiveSocket_;
+    case Role::Idle:
+      return idleSocket_;
+    case Role::Bulk:
+      break;
+  }
+
+  std::shared_ptr<MPDSocket> leastBusy;
+  for (const std::shared_ptr<MPDSocket> &bulkSocket : bulkSockets_) {
+    if (!bulkSocket->isHealthy()) continue;
+    if (!leastBusy ||
+        bulkSocket->pendingCommandCount() < leastBusy->pendingCommandCount()) {
+      leastBusy = bulkSocket;
+    }
+  }
+  return leastBusy ? leastBusy : interactiveSocket_;
+}
+
+QList<MPDConnectionHealth> MPDConnectionPool::health() const {
+  QList<MPDConnectionHealth> connections;
+  connections << socketHealth(interactiveSocket_) << socketHealth(idleSocket_);
+  for (const std::shared_ptr<MPDSocket> &bulkSocket : bulkSockets_) {
+    connections << socketHealth(bulkSocket);
+  }
+  return connections;
+}
+
+MPDConnectionHealth MPDConnectionPool::socketHealth(
+    const std::shared_ptr<MPDSocket> &socket) {
+  MPDConnectionHealth health;
+  health.name = socket->objectName();
+  health.healthy = socket->isHealthy();
+  health.pendingCommands = socket->pendingCommandCount();
+  health.latency = socket->latency();
+  return health;
+}
@@ -0,0 +1,77 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MPDCONNECTIONPOOL_H
+#define MPDCONNECTIONPOOL_H
+
+#include <QList>
+#include <QMetaType>
+#include <QObject>
+#include <memory>
+
+class MPDSocket;
+
+struct MPDConnectionHealth {
+  MPDConnectionHealth() : healthy(false), pendingCommands(0), latency(-1) {}
+  QString name;
+  bool healthy;
+  int pendingCommands;
+  qint64 latency;
+};
+
+Q_DECLARE_METATYPE(MPDConnectionHealth)
+
+// Authenticated connections to one MPD server, each with its own role so a
+// multi megabyte listing never delays a pause click queued behind it.
+class MPDConnectionPool : public QObject {
+  Q_OBJECT
+ public:
+  enum class Role {
+    Interactive,  // playback & other short commands
+    Idle,         // parked in idle by MPDIdleListener
+    Bulk,         // library, folder & queue listings
+  };
+
+  explicit MPDConnectionPool(QObject *parent = nullptr,
+                             const int bulkConnections = 1);
+  ~MPDConnectionPool();
+
+  // Only the interactive connection is mandatory, idle & bulk connections
+  // that fail are left out & their work is routed elsewhere. Connections
+  // that are already up are left alone.
+  bool connectToHost(const QString &hostName, const quint16 port,
+                     const QString &password);
+  void disconnectFromHost();
+
+  // Bulk requests go to the least busy bulk connection, or to the
+  // interactive one if no bulk connection is available.
+  std::shared_ptr<MPDSocket> socket(const Role role) const;
+  QList<MPDConnectionHealth> health() const;
+
+ signals:
+  void commandsent(QString command, QByteArray result);
+  void healthChanged();
+
+ private:
+  std::shared_ptr<MPDSocket> interactiveSocket_;
+  std::shared_ptr<MPDSocket> idleSocket_;
+  QList<std::shared_ptr<MPDSocket>> bulkSockets_;
+
+  static MPDConnectionHealth socketHealth(
+      const std::shared_ptr<MPDSocket> &socket);
+};
+
+#endif  // MPDCONNECTIONPOOL_H
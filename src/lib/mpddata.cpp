@@ -15,207 +15,600 @@
 */
 
 #include "mpddata.h"
+#include "mpdconnectionpool.h"
+#include "mpdcommandlist.h"
 #include "mpddataparser.h"
+#include "mpdlibrarybuilder.h"
+#include "mpdlibrarycache.h"
 #include "mpdsocket.h"
 
+#include <QCoreApplication>
 #include <QDebug>
+#include <QSet>
+#include <QSettings>
+#include <QStringList>
+#include <QThread>
+#include <algorithm>
 
 const QByteArray MPDdata::statusCommand = "status";
 const QByteArray MPDdata::statsCommand = "stats";
 const QByteArray MPDdata::songMetadataCommand = "currentsong";
 const QByteArray MPDdata::playlistinfoCommand = "playlistinfo";
-const QByteArray MPDdata::listallCommand = "listall";
+const QByteArray MPDdata::plchangesCommand = "plchanges";
+const QByteArray MPDdata::plchangesposidCommand = "plchangesposid";
+const QByteArray MPDdata::lsinfoCommand = "lsinfo";
 const QByteArray MPDdata::listallinfoCommand = "listallinfo";
 
-MPDdata::MPDdata(QObject* parent, std::shared_ptr<MPDSocket> mpdSocket)
-    : QObject(parent),
-      mpdSocket_(mpdSocket),
-      statusValues_(new MPDStatusValues),
-      statsValues_(new MPDStatsValues),
-      songMetadataValues_(new MPDSongMetadata),
-      playlistQueue_(new QList<MPDSongMetadata*>()),
-      rootitem_(new RootItem(QString(""))),
-      libraryItemArtistValues_(new QList<MusicLibraryItemArtist*>()) {}
+// Queues longer than this are only fetched a page at a time, as they are
+// shown
+static quint32 virtualQueueLength() {
+  QSettings settings;
+  return settings.value("virtual-queue-length", 100000).toUInt();
+}
 
-MPDdata::~MPDdata() {
-  delete statusValues_;
-  delete statsValues_;
-  delete songMetadataValues_;
+MPDdata::MPDdata(QObject* parent,
+                 std::shared_ptr<MPDConnectionPool> connectionPool)
+    : QObject(parent),
+      connectionPool_(connectionPool),
+      libraryGeneration_(0),
+      queueVersion_(0),
+      queueFetched_(false),
+      virtualQueue_(false),
+      virtualQueueLength_(virtualQueueLength()),
+      status_(new MPDStatusValues),
+      stats_(new MPDStatsValues),
+      songMetadata_(new MPDSongMetadata),
+      rootitem_(new RootItem(QString(""))) {
+  // The snapshots are adopted in the thread of the application object, the
+  // GUI thread, we are moved to the MPD thread after construction.
+  QObject* gui = QCoreApplication::instance();
+  connect(this, &MPDdata::statusParsed, gui,
+          [this](const MPDStatusSnapshot &status) {
+            status_ = status;
+            emit MPDStatusUpdated();
+          },
+          Qt::QueuedConnection);
+  connect(this, &MPDdata::statsParsed, gui,
+          [this](const MPDStatsSnapshot &stats) {
+            stats_ = stats;
+            emit MPDStatsUpdated();
+          },
+          Qt::QueuedConnection);
+  connect(this, &MPDdata::songMetadataParsed, gui,
+          [this](const MPDSongSnapshot &songMetadata) {
+            songMetadata_ = songMetadata;
+            emit MPDSongMetadataUpdated(songMetadata_->file);
+          },
+          Qt::QueuedConnection);
+  connect(this, &MPDdata::playlistinfoParsed, gui,
+          [this](const MPDPlaylistSnapshot &playlistQueue) {
+            emit MPDPlaylistinfoUpdated(playlistQueue);
+          },
+          Qt::QueuedConnection);
+  connect(this, &MPDdata::queueChangesParsed, gui,
+          [this](const MPDQueueChangesSnapshot &changes) {
+            emit MPDPlaylistChanged(changes);
+          },
+          Qt::QueuedConnection);
+  connect(this, &MPDdata::folderTreeParsed, gui,
+          [this](const std::shared_ptr<RootItem> &rootitem) {
+            // the old tree is freed once the folder view switched over
+            const std::shared_ptr<RootItem> oldRootitem = rootitem_;
+            rootitem_ = rootitem;
+            emit MPDFolderTreeUpdated(rootitem_.get());
+          },
+          Qt::QueuedConnection);
 }
 
+MPDdata::~MPDdata() {}
+
 void MPDdata::getMPDStatus() {
-  QPair<QByteArray, bool> mpdStatus(mpdSocket_->sendCommand(statusCommand));
-  if (mpdStatus.second) {
-    MPDdataParser::parseStatus(mpdStatus.first, statusValues_);
-    emit MPDStatusUpdated();
-  }
+  if (postToOwnThread("getMPDStatus")) return;
+  interactiveSocket()->sendCommand(
+      statusCommand, [this](const QPair<QByteArray, bool> &mpdStatus) {
+        if (mpdStatus.second) {
+          MPDdataParser::parseStatus(mpdStatus.first, &statusValues_);
+          emit statusParsed(
+              MPDStatusSnapshot(new MPDStatusValues(statusValues_)));
+        }
+      });
 }
 
 void MPDdata::getMPDStats() {
-  QPair<QByteArray, bool> mpdStats(mpdSocket_->sendCommand(statsCommand));
-  if (mpdStats.second) {
-    MPDdataParser::parseStats(mpdStats.first, statsValues_);
-    emit MPDStatsUpdated();
-  }
+  if (postToOwnThread("getMPDStats")) return;
+  interactiveSocket()->sendCommand(
+      statsCommand, [this](const QPair<QByteArray, bool> &mpdStats) {
+        if (mpdStats.second) {
+          MPDdataParser::parseStats(mpdStats.first, &statsValues_);
+          emit statsParsed(MPDStatsSnapshot(new MPDStatsValues(statsValues_)));
+        }
+      });
 }
 
 void MPDdata::getMPDSongMetadata() {
-  QPair<QByteArray, bool> mpdSongMetadata(
-      mpdSocket_->sendCommand(songMetadataCommand));
-  if (mpdSongMetadata.second) {
-    MPDdataParser::parseSongMetadata(mpdSongMetadata.first.split('\n'),
-                                     songMetadataValues_);
-    emit MPDSongMetadataUpdated(songMetadataValues_->file);
-  }
+  if (postToOwnThread("getMPDSongMetadata")) return;
+  interactiveSocket()->sendCommand(
+      songMetadataCommand,
+      [this](const QPair<QByteArray, bool> &mpdSongMetadata) {
+        if (mpdSongMetadata.second) {
+          MPDdataParser::parseSongMetadata(mpdSongMetadata.first,
+                                           &songMetadataValues_);
+          emit songMetadataParsed(
+              MPDSongSnapshot(new MPDSongMetadata(songMetadataValues_)));
+        }
+      });
 }
 
 void MPDdata::getMPDPlaylistInfo() {
-  QPair<QByteArray, bool> mpdplaylistinfo(
-      mpdSocket_->sendCommand(playlistinfoCommand));
-  if (mpdplaylistinfo.second) {
-    qDeleteAll(playlistQueue_->begin(), playlistQueue_->end());
-    playlistQueue_->clear();
-    MPDdataParser::parsePlaylistQueue(mpdplaylistinfo.first, playlistQueue_);
-    emit MPDPlaylistinfoUpdated(playlistQueue_);
+  if (postToOwnThread("getMPDPlaylistInfo")) return;
+  if (statusValues_.playlistLength > virtualQueueLength_) {
+    // nothing held to apply changes to once the queue shrinks again
+    queueFetched_ = false;
+    queueIds_ = QVector<qint32>();
+    fetchVirtualQueueChanges();
+    return;
+  }
+  virtualQueue_ = false;
+  if (!queueFetched_) {
+    fetchQueue();
+    return;
+  }
+  // positions & ids suffice unless songs were added
+  fetchQueueChanges(false);
+}
+
+void MPDdata::reloadMPDPlaylistInfo() {
+  if (postToOwnThread("reloadMPDPlaylistInfo")) return;
+  queueFetched_ = false;
+  virtualQueue_ = false;
+  getMPDPlaylistInfo();
+}
+
+void MPDdata::getMPDPlaylistRange(const quint32 start, const quint32 end) {
+  if (thread() != QThread::currentThread()) {
+    QMetaObject::invokeMethod(this, "getMPDPlaylistRange",
+                              Qt::QueuedConnection, Q_ARG(quint32, start),
+                              Q_ARG(quint32, end));
+    return;
   }
+  // the rows wait to be shown, so the interactive connection, with the
+  // status telling which version of the queue they are from
+  MPDCommandList commandList(interactiveSocket());
+  commandList.add(statusCommand)
+      .add(playlistinfoCommand + ' ' + QByteArray::number(start) + ':' +
+           QByteArray::number(end));
+  commandList.send([this, start](const QList<QPair<QByteArray, bool>> &results,
+                                 int failedIndex) {
+    QList<MPDSongMetadata> *songs = new QList<MPDSongMetadata>;
+    MPDStatusValues status;
+    if (failedIndex == -1 && results.size() == 2) {
+      MPDdataParser::parseStatus(results.at(0).first, &status);
+      MPDdataParser::parsePlaylistQueue(results.at(1).first, songs);
+    }
+    emit MPDPlaylistRangeFetched(status.playlist, start,
+                                 MPDPlaylistSnapshot(songs));
+  });
 }
 
-void MPDdata::getMPDListall() {
-  QPair<QByteArray, bool> mpdlistall(mpdSocket_->sendCommand(listallCommand));
-  if (mpdlistall.second) {
-    // delete all childs from all depth
-    rootitem_->clear();
-    MPDdataParser::parseFolderView(mpdlistall.first, rootitem_);
-    emit MPDListallUpdated(rootitem_);
+void MPDdata::getMPDDirectory(const QString &path) {
+  if (thread() != QThread::currentThread()) {
+    QMetaObject::invokeMethod(this, "getMPDDirectory", Qt::QueuedConnection,
+                              Q_ARG(QString, path));
+    return;
   }
+  bulkSocket()->sendCommand(
+      lsinfoCommand + ' ' + MPDCommandList::quote(path),
+      [this, path](const QPair<QByteArray, bool> &mpdlsinfo) {
+        if (!mpdlsinfo.second) return;
+        QStringList directories;
+        QStringList files;
+        MPDdataParser::parseDirectory(mpdlsinfo.first, &directories, &files);
+        emit MPDDirectoryFetched(path, directories, files);
+      });
 }
 
 void MPDdata::getMPDLibrary() {
-  QPair<QByteArray, bool> mpdlibrary(mpdSocket_->sendCommand(listallinfoCommand));
-  if (mpdlibrary.second) {
-    // delete all childs from all depth
-    libraryItemArtistValues_->clear();
-    MPDdataParser::parseLibraryItems(mpdlibrary.first,
-                                     libraryItemArtistValues_);
-    emit MPDLibraryUpdated(libraryItemArtistValues_);
+  if (postToOwnThread("getMPDLibrary")) return;
+  // songs are handed on batch by batch as they arrive so the library view
+  // fills while MPD is still sending, a newer request supersedes this one
+  const quint32 generation = ++libraryGeneration_;
+  std::shared_ptr<QList<MPDSongMetadata>> songs(new QList<MPDSongMetadata>);
+  std::shared_ptr<MPDdataParser::RecordStreamParser> parser(
+      new MPDdataParser::RecordStreamParser(
+          [songs](const QByteArray &record) {
+            MPDSongMetadata song;
+            MPDdataParser::parseSongMetadata(record, &song);
+            // directory & playlist records carry no file
+            if (!song.file.isEmpty()) songs->append(song);
+          }));
+
+  emit MPDLibraryUpdateStarted();
+  bulkSocket()->sendCommand(
+      listallinfoCommand,
+      [this, generation, songs, parser](const QByteArray &chunk) {
+        if (generation != libraryGeneration_) return;
+        parser->feed(chunk);
+        if (songs->isEmpty()) return;
+        emit MPDLibrarySongsReceived(*songs);
+        songs->clear();
+      },
+      [this, generation, songs, parser](
+          const QPair<QByteArray, bool> &mpdlibrary) {
+        if (generation != libraryGeneration_) return;
+        if (mpdlibrary.second) {
+          parser->finish();
+          if (!songs->isEmpty()) emit MPDLibrarySongsReceived(*songs);
+          songs->clear();
+        }
+        emit MPDLibraryUpdateFinished(mpdlibrary.second);
+      });
+}
+
+void MPDdata::loadCachedListings(const QString &host) {
+  if (thread() != QThread::currentThread()) {
+    QMetaObject::invokeMethod(this, "loadCachedListings", Qt::QueuedConnection,
+                              Q_ARG(QString, host));
+    return;
+  }
+
+  QDateTime cachedDbUpdate;
+  MusicLibraryItemRoot *const library =
+      MPDLibraryCache(host).read(&cachedDbUpdate);
+  if (library) {
+    // The folder tree starts out with the same files, its folders are
+    // still listed with lsinfo once expanded for what holds no songs
+    const MPDSongTable *const songs = library->songs();
+    std::shared_ptr<RootItem> rootitem(new RootItem(QString("")));
+    MPDdataParser::FolderViewBuilder builder(rootitem.get());
+    for (int i = 0; i < songs->size(); i++) {
+      builder.addFile(songs->file(static_cast<quint32>(i)));
+    }
+
+    library->searchIndex()->update();
+
+    emit folderTreeParsed(rootitem);
+    emit MPDLibraryCacheLoaded(library, cachedDbUpdate);
+  }
+
+  interactiveSocket()->sendCommand(
+      statsCommand,
+      [this, cachedDbUpdate](const QPair<QByteArray, bool> &mpdStats) {
+        if (!mpdStats.second) return;
+        MPDdataParser::parseStats(mpdStats.first, &statsValues_);
+        emit statsParsed(MPDStatsSnapshot(new MPDStatsValues(statsValues_)));
+        if (!cachedDbUpdate.isValid() ||
+            cachedDbUpdate.toTime_t() != statsValues_.dbUpdate) {
+          resetFolderTree();
+          getMPDLibrary();
+        }
+      });
+}
+
+void MPDdata::writeLibraryCache(const QString &host,
+                                const MPDLibrarySnapshot &library,
+                                const MPDLibraryCache::Order &order,
+                                const QDateTime &dbUpdate) {
+  if (thread() != QThread::currentThread()) {
+    QMetaObject::invokeMethod(this, "writeLibraryCache", Qt::QueuedConnection,
+                              Q_ARG(QString, host),
+                              Q_ARG(MPDLibrarySnapshot, library),
+                              Q_ARG(MPDLibraryCache::Order, order),
+                              Q_ARG(QDateTime, dbUpdate));
+    return;
+  }
+  MPDLibraryCache(host).write(library.get(), order, dbUpdate);
+}
+
+void MPDdata::orderLibrary(MusicLibraryItemRoot *library,
+                           const QDateTime &dbUpdate) {
+  if (thread() != QThread::currentThread()) {
+    QMetaObject::invokeMethod(this, "orderLibrary", Qt::QueuedConnection,
+                              Q_ARG(MusicLibraryItemRoot *, library),
+                              Q_ARG(QDateTime, dbUpdate));
+    return;
+  }
+  MusicLibraryBuilder(library).sort();
+  emit MPDLibraryOrdered(library, dbUpdate);
+}
+
+void MPDdata::resync() {
+  if (postToOwnThread("resync")) return;
+  const quint32 playlist = statusValues_.playlist;
+  const time_t dbUpdate = statsValues_.dbUpdate;
+
+  interactiveSocket()->sendCommand(
+      statusCommand,
+      [this, playlist](const QPair<QByteArray, bool> &mpdStatus) {
+        if (!mpdStatus.second) return;
+        MPDdataParser::parseStatus(mpdStatus.first, &statusValues_);
+        emit statusParsed(
+            MPDStatusSnapshot(new MPDStatusValues(statusValues_)));
+        // a restarted MPD may count the version from scratch, so any
+        // difference counts
+        if (statusValues_.playlist != playlist) {
+          queueFetched_ = false;
+          getMPDPlaylistInfo();
+        }
+      });
+  interactiveSocket()->sendCommand(
+      statsCommand,
+      [this, dbUpdate](const QPair<QByteArray, bool> &mpdStats) {
+        if (!mpdStats.second) return;
+        MPDdataParser::parseStats(mpdStats.first, &statsValues_);
+        emit statsParsed(MPDStatsSnapshot(new MPDStatsValues(statsValues_)));
+        if (statsValues_.dbUpdate != dbUpdate) {
+          resetFolderTree();
+          getMPDLibrary();
+        }
+      });
+}
+
+std::shared_ptr<MPDSocket> MPDdata::interactiveSocket() const {
+  return connectionPool_->socket(MPDConnectionPool::Role::Interactive);
+}
+
+std::shared_ptr<MPDSocket> MPDdata::bulkSocket() const {
+  return connectionPool_->socket(MPDConnectionPool::Role::Bulk);
+}
+
+void MPDdata::fetchQueue() {
+  // the queue requests all go through one connection, so their replies
+  // arrive in order & the versions they carry only grow
+  MPDCommandList commandList(bulkSocket());
+  commandList.add(statusCommand).add(playlistinfoCommand);
+  commandList.send([this](const QList<QPair<QByteArray, bool>> &results,
+                          int failedIndex) {
+    if (failedIndex != -1 || results.size() != 2) return;
+    MPDStatusValues status;
+    MPDdataParser::parseStatus(results.at(0).first, &status);
+    QList<MPDSongMetadata> *playlistQueue = new QList<MPDSongMetadata>;
+    MPDdataParser::parsePlaylistQueue(results.at(1).first, playlistQueue);
+
+    queueIds_.clear();
+    queueIds_.reserve(playlistQueue->size());
+    for (const MPDSongMetadata &song : *playlistQueue) {
+      queueIds_.append(song.id);
+    }
+    queueVersion_ = status.playlist;
+    queueFetched_ = true;
+    emit playlistinfoParsed(MPDPlaylistSnapshot(playlistQueue));
+  });
+}
+
+void MPDdata::fetchQueueChanges(const bool withMetadata) {
+  MPDCommandList commandList(bulkSocket());
+  commandList.add(statusCommand)
+      .add((withMetadata ? plchangesCommand : plchangesposidCommand) + ' ' +
+           QByteArray::number(queueVersion_));
+  commandList.send([this, withMetadata](
+                       const QList<QPair<QByteArray, bool>> &results,
+                       int failedIndex) {
+    if (failedIndex != -1 || results.size() != 2) {
+      fetchQueue();
+      return;
+    }
+    MPDStatusValues status;
+    MPDdataParser::parseStatus(results.at(0).first, &status);
+    // an earlier request already brought the queue up to date
+    if (!queueFetched_ || status.playlist == queueVersion_) return;
+
+    std::shared_ptr<MPDQueueChanges> changes(new MPDQueueChanges);
+    changes->length = status.playlistLength;
+    if (withMetadata) {
+      MPDdataParser::parsePlaylistQueue(results.at(1).first, &changes->songs);
+    } else {
+      MPDdataParser::parseQueuePositions(results.at(1).first,
+                                         &changes->songs);
+    }
+
+    // Changes since an older version still apply to a newer queue, the
+    // positions left out have not changed since the older one. A position
+    // neither held nor listed means the changes do not fit what we hold.
+    const int length = static_cast<int>(changes->length);
+    QVector<qint32> queueIds(length, -1);
+    std::copy_n(queueIds_.constBegin(), qMin(queueIds_.size(), length),
+                queueIds.begin());
+    QSet<qint32> heldIds;
+    heldIds.reserve(queueIds_.size());
+    for (const qint32 id : queueIds_) heldIds.insert(id);
+    bool complete = true;
+    for (const MPDSongMetadata &song : changes->songs) {
+      if (song.pos >= changes->length) continue;
+      queueIds[static_cast<int>(song.pos)] = song.id;
+      if (song.file.isEmpty() && !heldIds.contains(song.id)) complete = false;
+    }
+    if (queueIds.contains(-1)) {
+      fetchQueue();
+      return;
+    }
+    if (!complete) {
+      // songs were added, their metadata is needed
+      if (withMetadata) {
+        fetchQueue();
+      } else {
+        fetchQueueChanges(true);
+      }
+      return;
+    }
+
+    queueIds_ = queueIds;
+    queueVersion_ = status.playlist;
+    emit queueChangesParsed(changes);
+  });
+}
+
+void MPDdata::fetchVirtualQueueChanges() {
+  if (!virtualQueue_) {
+    virtualQueue_ = true;
+    queueVersion_ = statusValues_.playlist;
+    emit MPDPlaylistResized(queueVersion_, statusValues_.playlistLength, 0);
+    return;
+  }
+
+  // the positions & ids MPD lists start where the queue changed
+  MPDCommandList commandList(bulkSocket());
+  commandList.add(statusCommand)
+      .add(plchangesposidCommand + ' ' + QByteArray::number(queueVersion_));
+  commandList.send([this](const QList<QPair<QByteArray, bool>> &results,
+                          int failedIndex) {
+    MPDStatusValues status;
+    QList<MPDSongMetadata> changes;
+    quint32 firstChanged = 0;
+    if (failedIndex == -1 && results.size() == 2) {
+      MPDdataParser::parseStatus(results.at(0).first, &status);
+      // An earlier request already brought the queue up to date, or it
+      // is short enough to hold again as the next status will tell
+      if (!virtualQueue_ || status.playlist == queueVersion_ ||
+          status.playlistLength <= virtualQueueLength_) {
+        return;
+      }
+      MPDdataParser::parseQueuePositions(results.at(1).first, &changes);
+      firstChanged = status.playlistLength;
+      for (const MPDSongMetadata &song : changes) {
+        firstChanged = qMin(firstChanged, song.pos);
+      }
+    } else {
+      status = statusValues_;
+    }
+    queueVersion_ = status.playlist;
+    emit MPDPlaylistResized(status.playlist, status.playlistLength,
+                            firstChanged);
+  });
+}
+
+void MPDdata::resetFolderTree() {
+  emit folderTreeParsed(std::shared_ptr<RootItem>(new RootItem(QString(""))));
+}
+
+bool MPDdata::postToOwnThread(const char* method) {
+  if (thread() == QThread::currentThread()) return false;
+  QMetaObject::invokeMethod(this, method, Qt::QueuedConnection);
+  return true;
+}
+
+void MPDdata::update(MPDIdleListener::Subsystems subsystems) {
+  // player, mixer, options & playlist changes are all reflected in status,
+  // the receivers of MPDStatusUpdated fetch the current song & queue when
+  // its song id or playlist version changed
+  if (subsystems & (MPDIdleListener::Player | MPDIdleListener::Mixer |
+                    MPDIdleListener::Options | MPDIdleListener::Playlist)) {
+    getMPDStatus();
+  }
+
+  if (subsystems & MPDIdleListener::Database) {
+    getMPDStats();
+    resetFolderTree();
+    getMPDLibrary();
   }
 }
 
 // MPD status
-qint8 MPDdata::volume() const { return statusValues_->volume; }
+qint8 MPDdata::volume() const { return status_->volume; }
 
-bool MPDdata::consume() const { return statusValues_->consume; }
+bool MPDdata::consume() const { return status_->consume; }
 
-bool MPDdata::repeat() const { return statusValues_->repeat; }
+bool MPDdata::repeat() const { return status_->repeat; }
 
-bool MPDdata::single() const { return statusValues_->single; }
+bool MPDdata::single() const { return status_->single; }
 
-bool MPDdata::random() const { return statusValues_->random; }
+bool MPDdata::random() const { return status_->random; }
 
-quint32 MPDdata::playlist() const { return statusValues_->playlist; }
+quint32 MPDdata::playlist() const { return status_->playlist; }
 
 quint32 MPDdata::playlistLength() const {
-  return statusValues_->playlistLength;
+  return status_->playlistLength;
 }
 
-qint32 MPDdata::crossFade() const { return statusValues_->crossFade; }
+qint32 MPDdata::crossFade() const { return status_->crossFade; }
 
-MPDPlaybackState MPDdata::state() const { return statusValues_->state; }
+MPDPlaybackState MPDdata::state() const { return status_->state; }
 
-qint32 MPDdata::song() const { return statusValues_->song; }
+qint32 MPDdata::song() const { return status_->song; }
 
-qint32 MPDdata::songId() const { return statusValues_->songId; }
+qint32 MPDdata::songId() const { return status_->songId; }
 
-qint32 MPDdata::nextSong() const { return statusValues_->nextSong; }
+qint32 MPDdata::nextSong() const { return status_->nextSong; }
 
-qint32 MPDdata::nextSongId() const { return statusValues_->nextSongId; }
+qint32 MPDdata::nextSongId() const { return status_->nextSongId; }
 
-qint32 MPDdata::timeElapsed() const { return statusValues_->timeElapsed; }
+qint32 MPDdata::timeElapsed() const { return status_->timeElapsed; }
 
-qint32 MPDdata::timeTotal() const { return statusValues_->timeTotal; }
+qint32 MPDdata::timeTotal() const { return status_->timeTotal; }
 
-quint16 MPDdata::bitrate() const { return statusValues_->bitrate; }
+quint16 MPDdata::bitrate() const { return status_->bitrate; }
 
-quint16 MPDdata::samplerate() const { return statusValues_->samplerate; }
+quint16 MPDdata::samplerate() const { return status_->samplerate; }
 
-quint8 MPDdata::bits() const { return statusValues_->bits; }
+quint8 MPDdata::bits() const { return status_->bits; }
 
-quint8 MPDdata::channels() const { return statusValues_->channels; }
+quint8 MPDdata::channels() const { return status_->channels; }
 
-qint32 MPDdata::updatingDb() const { return statusValues_->updatingDb; }
+qint32 MPDdata::updatingDb() const { return status_->updatingDb; }
 
-const QString& MPDdata::error() const { return statusValues_->error; }
+const QString& MPDdata::error() const { return status_->error; }
 
-MPDStatusValues* MPDdata::getStatusValues() const { return statusValues_; }
+MPDStatusSnapshot MPDdata::getStatusValues() const { return status_; }
 
 // MPD stats
-quint32 MPDdata::artists() const { return statsValues_->artists; }
+quint32 MPDdata::artists() const { return stats_->artists; }
 
-quint32 MPDdata::albums() const { return statsValues_->albums; }
+quint32 MPDdata::albums() const { return stats_->albums; }
 
-quint32 MPDdata::songs() const { return statsValues_->songs; }
+quint32 MPDdata::songs() const { return stats_->songs; }
 
-quint32 MPDdata::uptime() const { return statsValues_->uptime; }
+quint32 MPDdata::uptime() const { return stats_->uptime; }
 
-quint32 MPDdata::playtime() const { return statsValues_->playtime; }
+quint32 MPDdata::playtime() const { return stats_->playtime; }
 
-quint32 MPDdata::dbPlaytime() const { return statsValues_->dbPlaytime; }
+quint32 MPDdata::dbPlaytime() const { return stats_->dbPlaytime; }
 
-time_t MPDdata::dbUpdate() const { return statsValues_->dbUpdate; }
+time_t MPDdata::dbUpdate() const { return stats_->dbUpdate; }
 
-MPDStatsValues* MPDdata::getStatsValues() const { return statsValues_; }
+MPDStatsSnapshot MPDdata::getStatsValues() const { return stats_; }
 
 // MPD song metadata
-QString MPDdata::file() const { return songMetadataValues_->file; }
+QString MPDdata::file() const { return songMetadata_->file; }
 
-QString MPDdata::artist() const { return songMetadataValues_->artist; }
+QString MPDdata::artist() const { return songMetadata_->artist; }
 
-QString MPDdata::album() const { return songMetadataValues_->album; }
+QString MPDdata::album() const { return songMetadata_->album; }
 
-QString MPDdata::albumId() const { return songMetadataValues_->albumId; }
+QString MPDdata::albumId() const { return songMetadata_->albumId; }
 
 QString MPDdata::albumArtist() const {
-  return songMetadataValues_->albumArtist;
+  return songMetadata_->albumArtist;
 }
 
-QString MPDdata::title() const { return songMetadataValues_->title; }
+QString MPDdata::title() const { return songMetadata_->title; }
 
-quint16 MPDdata::track() const { return songMetadataValues_->track; }
+quint16 MPDdata::track() const { return songMetadata_->track; }
 
-QString MPDdata::name() const { return songMetadataValues_->name; }
+QString MPDdata::name() const { return songMetadata_->name; }
 
-QString MPDdata::genre() const { return songMetadataValues_->genre; }
+QString MPDdata::genre() const { return songMetadata_->genre; }
 
-quint16 MPDdata::date() const { return songMetadataValues_->date; }
+quint16 MPDdata::date() const { return songMetadata_->date; }
 
-QString MPDdata::composer() const { return songMetadataValues_->composer; }
+QString MPDdata::composer() const { return songMetadata_->composer; }
 
-QString MPDdata::performer() const { return songMetadataValues_->performer; }
+QString MPDdata::performer() const { return songMetadata_->performer; }
 
-QString MPDdata::comment() const { return songMetadataValues_->comment; }
+QString MPDdata::comment() const { return songMetadata_->comment; }
 
-quint8 MPDdata::disc() const { return songMetadataValues_->disc; }
+quint8 MPDdata::disc() const { return songMetadata_->disc; }
 
-quint16 MPDdata::time() const { return songMetadataValues_->time; }
+quint16 MPDdata::time() const { return songMetadata_->time; }
 
-qint32 MPDdata::id() const { return songMetadataValues_->id; }
+qint32 MPDdata::id() const { return songMetadata_->id; }
 
 QString MPDdata::lastModified() const {
-  return songMetadataValues_->lastModified;
+  return songMetadata_->lastModified;
 }
 
-uint MPDdata::pos() const { return songMetadataValues_->pos; }
-
-MPDSongMetadata* MPDdata::getSongMetadataValues() const {
-  return songMetadataValues_;
-}
+uint MPDdata::pos() const { return songMetadata_->pos; }
 
-QList<MPDSongMetadata*>* MPDdata::getPlaylistinfoValues() const {
-  return playlistQueue_;
+MPDSongSnapshot MPDdata::getSongMetadataValues() const {
+  return songMetadata_;
 }
 
-RootItem* MPDdata::getListallValues() const { return rootitem_; }
-
-QList<MusicLibraryItemArtist*>* MPDdata::getLibraryValues() const {
-  return libraryItemArtistValues_;
-}
+RootItem* MPDdata::getFolderTree() const { return rootitem_.get(); }
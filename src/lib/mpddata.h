@@ -17,27 +17,31 @@
    along with Todi.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <QDateTime>
 #include <QObject>
+#include <QVector>
 #include <memory>
 
 #include "mpdfilemodel.h"
+#include "mpdidlelistener.h"
+#include "mpdlibrarycache.h"
 #include "mpdlibrarymodel.h"
 #include "mpdmodel.h"
 
+class MPDConnectionPool;
 class MPDSocket;
 
+// Lives in the MPD thread with the connections it talks to, requests may be
+// made from any thread. The getters return the snapshots last handed to the
+// GUI thread & are only for use there, where MPDStatusUpdated & the other
+// non library signals are emitted once the new snapshot is in place.
 class MPDdata : public QObject {
   Q_OBJECT
  public:
-  explicit MPDdata(QObject *parent = nullptr,
-                   std::shared_ptr<MPDSocket> mpdSocket = nullptr);
+  explicit MPDdata(
+      QObject *parent = nullptr,
+      std::shared_ptr<MPDConnectionPool> connectionPool = nullptr);
   ~MPDdata();
-  void getMPDStatus();
-  void getMPDStats();
-  void getMPDSongMetadata();
-  void getMPDPlaylistInfo();
-  void getMPDListall();
-  void getMPDLibrary();
 
   // MPD status
   qint8 volume() const;
@@ -61,7 +65,7 @@ class MPDdata : public QObject {
   quint8 channels() const;
   qint32 updatingDb() const;
   const QString &error() const;
-  MPDStatusValues *getStatusValues() const;
+  MPDStatusSnapshot getStatusValues() const;
 
   // MPD stats
   quint32 artists() const;
@@ -71,7 +75,7 @@ class MPDdata : public QObject {
   quint32 playtime() const;
   quint32 dbPlaytime() const;
   time_t dbUpdate() const;
-  MPDStatsValues *getStatsValues() const;
+  MPDStatsSnapshot getStatsValues() const;
 
   // MPD song metadata
   QString file() const;
@@ -92,36 +96,130 @@ class MPDdata : public QObject {
   qint32 id() const;
   QString lastModified() const;
   uint pos() const;
-  MPDSongMetadata *getSongMetadataValues() const;
+  MPDSongSnapshot getSongMetadataValues() const;
+
+  RootItem *getFolderTree() const;
 
-  QList<MPDSongMetadata *> *getPlaylistinfoValues() const;
-  RootItem *getListallValues() const;
-  QList<MusicLibraryItemArtist *> *getLibraryValues() const;
+ public slots:
+  void getMPDStatus();
+  void getMPDStats();
+  void getMPDSongMetadata();
+  // Fetches the whole queue the first time, after that only what changed
+  // since the playlist version last fetched. Queues longer than the
+  // virtual-queue-length setting are not fetched, only their length is
+  // published & the rows shown are fetched with getMPDPlaylistRange.
+  void getMPDPlaylistInfo();
+  // Fetches the whole queue again, when the one shown went out of step
+  void reloadMPDPlaylistInfo();
+  // Lists the songs at positions start up to end (exclusive)
+  void getMPDPlaylistRange(quint32 start, quint32 end);
+  // Lists the directory with lsinfo, for browsing folders one at a time
+  void getMPDDirectory(const QString &path);
+  void getMPDLibrary();
+  // Publishes the listings cached for host right away, then fetches the
+  // stats & refetches the listings only if MPD's database changed since.
+  void loadCachedListings(const QString &host);
+  // Stores the library in the cache of host, read back by the above, in
+  // the order MPDLibraryCache::order() took in the GUI thread
+  void writeLibraryCache(const QString &host,
+                         const MPDLibrarySnapshot &library,
+                         const MPDLibraryCache::Order &order,
+                         const QDateTime &dbUpdate);
+  // Orders a library received whole, see MusicLibraryBuilder::sort(), &
+  // hands it back in MPDLibraryOrdered
+  void orderLibrary(MusicLibraryItemRoot *library, const QDateTime &dbUpdate);
+  // After a reconnect, refetches the queue & the database listings only if
+  // their playlist version or db_update differ from what we hold. The queue
+  // is fetched whole, a restarted MPD numbers its versions & ids anew.
+  void resync();
+  // Refetches only what belongs to the changed subsystems
+  void update(MPDIdleListener::Subsystems subsystems);
 
  signals:
   void MPDStatusUpdated();
   void MPDStatsUpdated();
   void MPDSongMetadataUpdated(QString filename);
-  void MPDPlaylistinfoUpdated(QList<MPDSongMetadata *> *playlistQueue);
-  void MPDListallUpdated(RootItem *rootitem);
-  void MPDLibraryUpdated(
-      QList<MusicLibraryItemArtist *> *libraryItemArtistValues_);
+  // the whole queue, replaces the one held
+  void MPDPlaylistinfoUpdated(const MPDPlaylistSnapshot &playlistQueue);
+  // applies to the queue as of the last update, in the order emitted
+  void MPDPlaylistChanged(const MPDQueueChangesSnapshot &changes);
+  // The queue is too long to hold, it changed to version & length. The
+  // positions before firstChanged hold the same songs as before.
+  void MPDPlaylistResized(quint32 version, quint32 length,
+                          quint32 firstChanged);
+  // songs is empty if the range could not be listed
+  void MPDPlaylistRangeFetched(quint32 version, quint32 start,
+                               const MPDPlaylistSnapshot &songs);
+  // the folder tree was replaced, its folders fill via getMPDDirectory
+  void MPDFolderTreeUpdated(RootItem *rootitem);
+  void MPDDirectoryFetched(const QString &path, const QStringList &directories,
+                           const QStringList &files);
+  // the library arrives in batches, complete is false if the transfer
+  // failed & the batches received so far are all there is
+  void MPDLibraryUpdateStarted();
+  void MPDLibrarySongsReceived(const QList<MPDSongMetadata> &songs);
+  void MPDLibraryUpdateFinished(bool complete);
+  // the receiver takes over library
+  void MPDLibraryCacheLoaded(MusicLibraryItemRoot *library,
+                             const QDateTime &dbUpdate);
+  void MPDLibraryOrdered(MusicLibraryItemRoot *library,
+                         const QDateTime &dbUpdate);
+
+  // internal, carry what was parsed over to the GUI thread
+  void statusParsed(const MPDStatusSnapshot &status);
+  void statsParsed(const MPDStatsSnapshot &stats);
+  void songMetadataParsed(const MPDSongSnapshot &songMetadata);
+  void playlistinfoParsed(const MPDPlaylistSnapshot &playlistQueue);
+  void queueChangesParsed(const MPDQueueChangesSnapshot &changes);
+  void folderTreeParsed(const std::shared_ptr<RootItem> &rootitem);
 
  private:
-  std::shared_ptr<MPDSocket> mpdSocket_;
-  MPDStatusValues *statusValues_;
-  MPDStatsValues *statsValues_;
-  MPDSongMetadata *songMetadataValues_;
-  QList<MPDSongMetadata *> *playlistQueue_;
-  RootItem *rootitem_;
-  QList<MusicLibraryItemArtist *> *libraryItemArtistValues_;
+  std::shared_ptr<MPDConnectionPool> connectionPool_;
+  // status & metadata use the interactive connection, the potentially huge
+  // listings a bulk one
+  std::shared_ptr<MPDSocket> interactiveSocket() const;
+  std::shared_ptr<MPDSocket> bulkSocket() const;
+  // Queues the named request in our thread if called from another one
+  bool postToOwnThread(const char *method);
+  // Drops the folders fetched so far, they are fetched again on demand
+  void resetFolderTree();
+  // The whole queue or what changed since queueVersion_, each along with
+  // the status, which in the same command list matches the queue exactly.
+  // Changes are fetched with positions & ids only unless withMetadata.
+  void fetchQueue();
+  void fetchQueueChanges(bool withMetadata);
+  // the first position of a virtual queue changed since queueVersion_
+  void fetchVirtualQueueChanges();
+
+  // MPD thread: the values parsed into, MPD leaves out unset keys
+  MPDStatusValues statusValues_;
+  MPDStatsValues statsValues_;
+  MPDSongMetadata songMetadataValues_;
+  quint32 libraryGeneration_;
+  // the ids of the queue as last published by position & its version
+  QVector<qint32> queueIds_;
+  quint32 queueVersion_;
+  bool queueFetched_;
+  // queueVersion_ is that of the virtual queue last published
+  bool virtualQueue_;
+  const quint32 virtualQueueLength_;
+  // GUI thread: the snapshots last published
+  MPDStatusSnapshot status_;
+  MPDStatsSnapshot stats_;
+  MPDSongSnapshot songMetadata_;
+  std::shared_ptr<RootItem> rootitem_;
 
   static const QByteArray statusCommand;
   static const QByteArray statsCommand;
   static const QByteArray songMetadataCommand;
   const static QByteArray playlistinfoCommand;
-  const static QByteArray listallCommand;
+  const static QByteArray plchangesCommand;
+  const static QByteArray plchangesposidCommand;
+  const static QByteArray lsinfoCommand;
   const static QByteArray listallinfoCommand;
 };
 
+Q_DECLARE_METATYPE(std::shared_ptr<RootItem>)
+Q_DECLARE_METATYPE(MusicLibraryItemRoot *)
+
 #endif  // STATUS_H
@@ -1,348 +1,575 @@
 #include "mpddataparser.h"
 #include "mpdfilemodel.h"
-#include "mpdlibrarymodel.h"
+#include "mpdstringpool.h"
 #include <QDebug>
 
-// MPD status look up keys
-static const QByteArray statusVolumeKey("volume: ");
-static const QByteArray statusConsumeKey("consume: ");
-static const QByteArray statusRepeatKey("repeat: ");
-static const QByteArray statusSingleKey("single: ");
-static const QByteArray statusRandomKey("random: ");
-static const QByteArray statusPlaylistKey("playlist: ");
-static const QByteArray statusPlaylistLengthKey("playlistlength: ");
-static const QByteArray statusCrossfadeKey("xfade: ");
-static const QByteArray statusStateKey("state: ");
-static const QByteArray statusSongKey("song: ");
-static const QByteArray statusSongIdKey("songid: ");
-static const QByteArray statusNextSongKey("nextsong: ");
-static const QByteArray statusNextSongIdKey("nextsongid: ");
-static const QByteArray statusTimeKey("time: ");
-static const QByteArray statusBitrateKey("bitrate: ");
-static const QByteArray statusAudioKey("audio: ");
-static const QByteArray statusUpdatingDbKey("updating_db: ");
-static const QByteArray statusErrorKey("error: ");
-
-// MPD stats look up keys
-static const QByteArray statsArtistsKey("artists: ");
-static const QByteArray statsAlbumsKey("albums: ");
-static const QByteArray statsSongsKey("songs: ");
-static const QByteArray statsUptimeKey("uptime: ");
-static const QByteArray statsPlaytimeKey("playtime: ");
-static const QByteArray statsDbPlaytimeKey("db_playtime: ");
-static const QByteArray statsDbUpdateKey("db_update: ");
-
-// MPD song metadata look up keys
-static const QByteArray songMetadataFileKey("file: ");
-static const QByteArray songMetadataTimeKey("Time: ");
-static const QByteArray songMetadataAlbumKey("Album: ");
-static const QByteArray songMetadataArtistKey("Artist: ");
-static const QByteArray songMetadataAlbumArtistKey("AlbumArtist: ");
-static const QByteArray songMetadataComposerKey("Composer: ");
-static const QByteArray songMetadataTitleKey("Title: ");
-static const QByteArray songMetadataTrackKey("Track: ");
-static const QByteArray songMetadataIdKey("Id: ");
-static const QByteArray songMetadataDiscKey("Disc: ");
-static const QByteArray songMetadataDateKey("Date: ");
-static const QByteArray songMetadataGenreKey("Genre: ");
-static const QByteArray songMetadataNameKey("Name: ");
-static const QByteArray songMetadataAlbumIdKey("MUSICBRAINZ_ALBUMID: ");
-static const QByteArray songMetadataPerformerKey("Performer: ");
-static const QByteArray songMetadataCommentKey("Comment: ");
-static const QByteArray songMetadataLastModifiedKey("Last-Modified: ");
-static const QByteArray songMetadataPosKey("Pos: ");
+#include <cstring>
+
+namespace {
+// MPD look up keys, every "key: " prefix the parsers know about
+enum class Key {
+  Unknown,
+  // status
+  Volume,
+  Consume,
+  Repeat,
+  Single,
+  Random,
+  Playlist,  // also starts a stored playlist record of a listing
+  PlaylistLength,
+  Crossfade,
+  State,
+  Song,
+  SongId,
+  NextSong,
+  NextSongId,
+  Time,
+  Bitrate,
+  Audio,
+  UpdatingDb,
+  Error,
+  // stats
+  Artists,
+  Albums,
+  Songs,
+  Uptime,
+  Playtime,
+  DbPlaytime,
+  DbUpdate,
+  // song metadata
+  File,
+  SongTime,
+  Album,
+  Artist,
+  AlbumArtist,
+  Composer,
+  Title,
+  Track,
+  Id,
+  Disc,
+  Date,
+  Genre,
+  Name,
+  AlbumId,
+  Performer,
+  Comment,
+  LastModified,
+  Pos,
+  // plchangesposid
+  Cpos,
+  // directory record of a listing
+  Directory,
+};
+
+// longer keys are never looked up, MUSICBRAINZ_ALBUMID is the longest known
+const int maxKeyLength = 32;
+
+// FNV-1a, constexpr so the known keys are hashed at compile time & two of
+// them colliding fails the build as a duplicate case label
+constexpr quint32 keyHash(const char *key, const int length,
+                          const quint32 hash = 2166136261u) {
+  return length == 0
+             ? hash
+             : keyHash(key + 1, length - 1,
+                       (hash ^ static_cast<quint8>(*key)) * 16777619u);
+}
+
+Key lookupKey(const char *key, const int length) {
+  if (length > maxKeyLength) return Key::Unknown;
+
+  // one hash & one compare to tell a known key from an unknown one
+#define MPD_KEY(name, value)                                     \
+  case keyHash(name, sizeof(name) - 1):                          \
+    return (length == static_cast<int>(sizeof(name)) - 1 &&      \
+            memcmp(key, name, sizeof(name) - 1) == 0)            \
+               ? value                                           \
+               : Key::Unknown;
+
+  switch (keyHash(key, length)) {
+    MPD_KEY("volume", Key::Volume)
+    MPD_KEY("consume", Key::Consume)
+    MPD_KEY("repeat", Key::Repeat)
+    MPD_KEY("single", Key::Single)
+    MPD_KEY("random", Key::Random)
+    MPD_KEY("playlist", Key::Playlist)
+    MPD_KEY("playlistlength", Key::PlaylistLength)
+    MPD_KEY("xfade", Key::Crossfade)
+    MPD_KEY("state", Key::State)
+    MPD_KEY("song", Key::Song)
+    MPD_KEY("songid", Key::SongId)
+    MPD_KEY("nextsong", Key::NextSong)
+    MPD_KEY("nextsongid", Key::NextSongId)
+    MPD_KEY("time", Key::Time)
+    MPD_KEY("bitrate", Key::Bitrate)
+    MPD_KEY("audio", Key::Audio)
+    MPD_KEY("updating_db", Key::UpdatingDb)
+    MPD_KEY("error", Key::Error)
+    MPD_KEY("artists", Key::Artists)
+    MPD_KEY("albums", Key::Albums)
+    MPD_KEY("songs", Key::Songs)
+    MPD_KEY("uptime", Key::Uptime)
+    MPD_KEY("playtime", Key::Playtime)
+    MPD_KEY("db_playtime", Key::DbPlaytime)
+    MPD_KEY("db_update", Key::DbUpdate)
+    MPD_KEY("file", Key::File)
+    MPD_KEY("Time", Key::SongTime)
+    MPD_KEY("Album", Key::Album)
+    MPD_KEY("Artist", Key::Artist)
+    MPD_KEY("AlbumArtist", Key::AlbumArtist)
+    MPD_KEY("Composer", Key::Composer)
+    MPD_KEY("Title", Key::Title)
+    MPD_KEY("Track", Key::Track)
+    MPD_KEY("Id", Key::Id)
+    MPD_KEY("Disc", Key::Disc)
+    MPD_KEY("Date", Key::Date)
+    MPD_KEY("Genre", Key::Genre)
+    MPD_KEY("Name", Key::Name)
+    MPD_KEY("MUSICBRAINZ_ALBUMID", Key::AlbumId)
+    MPD_KEY("Performer", Key::Performer)
+    MPD_KEY("Comment", Key::Comment)
+    MPD_KEY("Last-Modified", Key::LastModified)
+    MPD_KEY("Pos", Key::Pos)
+    MPD_KEY("cpos", Key::Cpos)
+    MPD_KEY("directory", Key::Directory)
+  }
+#undef MPD_KEY
+  return Key::Unknown;
+}
+
+// A "key: value" line, value points into the reply
+struct Token {
+  Key key;
+  const char *value;
+  int length;
+};
+
+// Walks the lines of a reply in place, nothing is copied. Lines that are no
+// key value pair (OK, list_OK) are skipped.
+class Tokenizer {
+ public:
+  Tokenizer(const char *data, const int length)
+      : pos_(data), end_(data + length), line_(data) {}
+  explicit Tokenizer(const QByteArray &data)
+      : Tokenizer(data.constData(), data.size()) {}
+
+  bool next(Token *token) {
+    while (pos_ < end_) {
+      line_ = pos_;
+      const char *eol =
+          static_cast<const char *>(memchr(pos_, '\n', end_ - pos_));
+      if (!eol) eol = end_;
+      pos_ = (eol < end_) ? eol + 1 : end_;
+
+      const char *colon =
+          static_cast<const char *>(memchr(line_, ':', eol - line_));
+      if (!colon || colon + 1 >= eol || colon[1] != ' ') continue;
+
+      token->key = lookupKey(line_, colon - line_);
+      token->value = colon + 2;
+      token->length = eol - token->value;
+      return true;
+    }
+    return false;
+  }
+
+  // start of the line the last token was read from
+  const char *line() const { return line_; }
+
+ private:
+  const char *pos_;
+  const char *const end_;
+  const char *line_;
+};
+
+// A field of a value like "44100:24:2"
+struct Field {
+  const char *data;
+  int length;
+};
+
+// Splits a value at separator in place, returns the number of fields
+int splitValue(const Token &token, const char separator, Field *fields,
+               const int maxFields) {
+  const char *pos = token.value;
+  const char *const end = token.value + token.length;
+  int count = 0;
+  while (count < maxFields) {
+    const char *next =
+        static_cast<const char *>(memchr(pos, separator, end - pos));
+    if (!next) next = end;
+    fields[count].data = pos;
+    fields[count].length = next - pos;
+    count++;
+    if (next == end) break;
+    pos = next + 1;
+  }
+  return count;
+}
+
+// Leading integer of a value, parsing stops at the first non digit so
+// "3/12" yields 3
+qint64 toNumber(const char *value, const int length) {
+  const bool negative = length > 0 && value[0] == '-';
+  qint64 number = 0;
+  // 18 digits always fit
+  for (int i = negative ? 1 : 0;
+       i < length && i < 19 && value[i] >= '0' && value[i] <= '9'; i++) {
+    number = number * 10 + (value[i] - '0');
+  }
+  return negative ? -number : number;
+}
+
+inline qint64 toNumber(const Token &token) {
+  return toNumber(token.value, token.length);
+}
+
+inline qint64 toNumber(const Field &field) {
+  return toNumber(field.data, field.length);
+}
+
+inline QString toString(const Token &token) {
+  return QString::fromUtf8(token.value, token.length);
+}
+
+// for tag values that repeat across songs
+inline QString toPooledString(const Token &token) {
+  return MPDStringPool::instance().intern(token.value, token.length);
+}
+
+inline bool isValue(const Token &token, const QByteArray &value) {
+  return token.length == value.size() &&
+         memcmp(token.value, value.constData(), token.length) == 0;
+}
+
+// True for the lines that start a new record of a listing
+inline bool isRecordStart(const Key key) {
+  return key == Key::File || key == Key::Directory || key == Key::Playlist;
+}
+}  // namespace
 
 // MPD look up values
-static const QByteArray okValue("OK");
 static const QByteArray enabledValue("1");
 static const QByteArray PlayValue("play");
 static const QByteArray StopValue("stop");
 
 void MPDdataParser::parseStatus(const QByteArray &data,
                                 MPDStatusValues *statusValues) {
-  QList<QByteArray> lines = data.split('\n');
-
-  foreach (const QByteArray &line, lines) {
-    if (line.startsWith(statusVolumeKey)) {
-      statusValues->volume =
-          static_cast<qint8>(line.mid(statusVolumeKey.length()).toInt());
-    } else if (line.startsWith(statusConsumeKey)) {
-      statusValues->consume =
-          (line.mid(statusConsumeKey.length()) == enabledValue) ? true : false;
-    } else if (line.startsWith(statusRepeatKey)) {
-      statusValues->repeat =
-          (line.mid(statusRepeatKey.length()) == enabledValue) ? true : false;
-    } else if (line.startsWith(statusSingleKey)) {
-      statusValues->single =
-          (line.mid(statusSingleKey.length()) == enabledValue) ? true : false;
-    } else if (line.startsWith(statusRandomKey)) {
-      statusValues->random =
-          (line.mid(statusRandomKey.length()) == enabledValue) ? true : false;
-    } else if (line.startsWith(statusPlaylistKey)) {
-      statusValues->playlist = line.mid(statusPlaylistKey.length()).toUInt();
-    } else if (line.startsWith(statusPlaylistLengthKey)) {
-      statusValues->playlistLength = static_cast<quint32>(
-          line.mid(statusPlaylistLengthKey.length()).toInt());
-    } else if (line.startsWith(statusCrossfadeKey)) {
-      statusValues->crossFade = line.mid(statusCrossfadeKey.length()).toInt();
-    } else if (line.startsWith(statusStateKey)) {
-      QByteArray value = line.mid(statusStateKey.length());
-      if (PlayValue == value) {
-        statusValues->state = MPDPlaybackState::Playing;
-      } else if (StopValue == value) {
-        statusValues->state = MPDPlaybackState::Stopped;
-      } else {
-        statusValues->state = MPDPlaybackState::Paused;
-      }
-    } else if (line.startsWith(statusSongKey)) {
-      statusValues->song = line.mid(statusSongKey.length()).toInt();
-    } else if (line.startsWith(statusSongIdKey)) {
-      statusValues->songId = line.mid(statusSongIdKey.length()).toInt();
-    } else if (line.startsWith(statusNextSongKey)) {
-      statusValues->nextSong = line.mid(statusNextSongKey.length()).toInt();
-    } else if (line.startsWith(statusNextSongIdKey)) {
-      statusValues->nextSongId = line.mid(statusNextSongIdKey.length()).toInt();
-    } else if (line.startsWith(statusTimeKey)) {
-      QList<QByteArray> values = line.mid(statusTimeKey.length()).split(':');
-      if (values.length() > 1) {
-        statusValues->timeElapsed = values.at(0).toInt();
-        statusValues->timeTotal = values.at(1).toInt();
-      }
-      values.clear();
-    } else if (line.startsWith(statusBitrateKey)) {
-      statusValues->bitrate =
-          static_cast<quint16>(line.mid(statusBitrateKey.length()).toUInt());
-    } else if (line.startsWith(statusAudioKey)) {
-      QList<QByteArray> values = line.mid(statusAudioKey.length()).split(':');
-      if (values.length() == 3) {
-        statusValues->samplerate = static_cast<quint16>(values.at(0).toUInt());
-        statusValues->bits = static_cast<quint8>(values.at(1).toUInt());
-        statusValues->channels = static_cast<quint8>(values.at(2).toUInt());
-      }
-      values.clear();
-    } else if (line.startsWith(statusUpdatingDbKey)) {
-      statusValues->updatingDb = line.mid(statusUpdatingDbKey.length()).toInt();
-    } else if (line.startsWith(statusErrorKey)) {
-      statusValues->error =
-          QString::fromUtf8(line.mid(statusErrorKey.length()));
+  Tokenizer tokenizer(data);
+  Token token;
+  Field fields[3];
+
+  while (tokenizer.next(&token)) {
+    switch (token.key) {
+      case Key::Volume:
+        statusValues->volume = static_cast<qint8>(toNumber(token));
+        break;
+      case Key::Consume:
+        statusValues->consume = isValue(token, enabledValue);
+        break;
+      case Key::Repeat:
+        statusValues->repeat = isValue(token, enabledValue);
+        break;
+      case Key::Single:
+        statusValues->single = isValue(token, enabledValue);
+        break;
+      case Key::Random:
+        statusValues->random = isValue(token, enabledValue);
+        break;
+      case Key::Playlist:
+        statusValues->playlist = static_cast<quint32>(toNumber(token));
+        break;
+      case Key::PlaylistLength:
+        statusValues->playlistLength = static_cast<quint32>(toNumber(token));
+        break;
+      case Key::Crossfade:
+        statusValues->crossFade = static_cast<qint32>(toNumber(token));
+        break;
+      case Key::State:
+        if (isValue(token, PlayValue)) {
+          statusValues->state = MPDPlaybackState::Playing;
+        } else if (isValue(token, StopValue)) {
+          statusValues->state = MPDPlaybackState::Stopped;
+        } else {
+          statusValues->state = MPDPlaybackState::Paused;
+        }
+        break;
+      case Key::Song:
+        statusValues->song = static_cast<qint32>(toNumber(token));
+        break;
+      case Key::SongId:
+        statusValues->songId = static_cast<qint32>(toNumber(token));
+        break;
+      case Key::NextSong:
+        statusValues->nextSong = static_cast<qint32>(toNumber(token));
+        break;
+      case Key::NextSongId:
+        statusValues->nextSongId = static_cast<qint32>(toNumber(token));
+        break;
+      case Key::Time:
+        if (splitValue(token, ':', fields, 2) == 2) {
+          statusValues->timeElapsed = static_cast<qint32>(toNumber(fields[0]));
+          statusValues->timeTotal = static_cast<qint32>(toNumber(fields[1]));
+        }
+        break;
+      case Key::Bitrate:
+        statusValues->bitrate = static_cast<quint16>(toNumber(token));
+        break;
+      case Key::Audio:
+        if (splitValue(token, ':', fields, 3) == 3) {
+          statusValues->samplerate = static_cast<quint16>(toNumber(fields[0]));
+          statusValues->bits = static_cast<quint8>(toNumber(fields[1]));
+          statusValues->channels = static_cast<quint8>(toNumber(fields[2]));
+        }
+        break;
+      case Key::UpdatingDb:
+        statusValues->updatingDb = static_cast<qint32>(toNumber(token));
+        break;
+      case Key::Error:
+        statusValues->error = toString(token);
+        break;
+      default:
+        break;
     }
   }
-  lines.clear();
 }
 
 void MPDdataParser::parseStats(const QByteArray &data,
                                MPDStatsValues *statsValues) {
-  QList<QByteArray> lines = data.split('\n');
-
-  foreach (const QByteArray &line, lines) {
-    if (line.startsWith(statsArtistsKey)) {
-      statsValues->artists = line.mid(statsArtistsKey.length()).toUInt();
-    } else if (line.startsWith(statsAlbumsKey)) {
-      statsValues->albums = line.mid(statsAlbumsKey.length()).toUInt();
-    } else if (line.startsWith(statsSongsKey)) {
-      statsValues->songs = line.mid(statsSongsKey.length()).toUInt();
-    } else if (line.startsWith(statsUptimeKey)) {
-      statsValues->uptime = line.mid(statsUptimeKey.length()).toUInt();
-    } else if (line.startsWith(statsPlaytimeKey)) {
-      statsValues->playtime = line.mid(statsPlaytimeKey.length()).toUInt();
-    } else if (line.startsWith(statsDbPlaytimeKey)) {
-      statsValues->dbPlaytime = line.mid(statsDbPlaytimeKey.length()).toUInt();
-    } else if (line.startsWith(statsDbUpdateKey)) {
-      statsValues->dbUpdate = line.mid(statsDbUpdateKey.length()).toUInt();
+  Tokenizer tokenizer(data);
+  Token token;
+
+  while (tokenizer.next(&token)) {
+    switch (token.key) {
+      case Key::Artists:
+        statsValues->artists = static_cast<quint32>(toNumber(token));
+        break;
+      case Key::Albums:
+        statsValues->albums = static_cast<quint32>(toNumber(token));
+        break;
+      case Key::Songs:
+        statsValues->songs = static_cast<quint32>(toNumber(token));
+        break;
+      case Key::Uptime:
+        statsValues->uptime = static_cast<quint32>(toNumber(token));
+        break;
+      case Key::Playtime:
+        statsValues->playtime = static_cast<quint32>(toNumber(token));
+        break;
+      case Key::DbPlaytime:
+        statsValues->dbPlaytime = static_cast<quint32>(toNumber(token));
+        break;
+      case Key::DbUpdate:
+        statsValues->dbUpdate = static_cast<time_t>(toNumber(token));
+        break;
+      default:
+        break;
     }
   }
-  lines.clear();
 }
 
-void MPDdataParser::parseSongMetadata(const QList<QByteArray> &data,
+void MPDdataParser::parseSongMetadata(const QByteArray &data,
                                       MPDSongMetadata *songMetadataValues) {
-  foreach (const QByteArray &line, data) {
-    if (line.startsWith(songMetadataFileKey)) {
-      songMetadataValues->file =
-          QString::fromUtf8(line.mid(songMetadataFileKey.length()));
-    } else if (line.startsWith(songMetadataTimeKey)) {
-      songMetadataValues->time = line.mid(songMetadataTimeKey.length()).toInt();
-    } else if (line.startsWith(songMetadataAlbumKey)) {
-      songMetadataValues->album =
-          QString::fromUtf8(line.mid(songMetadataAlbumKey.length()));
-    } else if (line.startsWith(songMetadataArtistKey)) {
-      songMetadataValues->artist =
-          QString::fromUtf8(line.mid(songMetadataArtistKey.length()));
-    } else if (line.startsWith(songMetadataAlbumArtistKey)) {
-      songMetadataValues->albumArtist =
-          QString::fromUtf8(line.mid(songMetadataAlbumArtistKey.length()));
-    } else if (line.startsWith(songMetadataComposerKey)) {
-      songMetadataValues->comment =
-          QString::fromUtf8(line.mid(songMetadataComposerKey.length()));
-    } else if (line.startsWith(songMetadataTitleKey)) {
-      songMetadataValues->title =
-          QString::fromUtf8(line.mid(songMetadataTitleKey.length()));
-    } else if (line.startsWith(songMetadataTrackKey)) {
-      int v = line.mid(songMetadataTrackKey.length()).split('/').at(0).toInt();
-      songMetadataValues->track = v < 0 ? 0 : v;
-    } else if (line.startsWith(songMetadataIdKey)) {
-      songMetadataValues->id = line.mid(songMetadataIdKey.length()).toUInt();
-    } else if (line.startsWith(songMetadataDiscKey)) {
-      int v = line.mid(songMetadataDiscKey.length()).split('/').at(0).toInt();
-      songMetadataValues->disc = v < 0 ? 0 : v;
-    } else if (line.startsWith(songMetadataDateKey)) {
-      QByteArray value = line.mid(songMetadataDateKey.length());
-      int v = value.length() > 4 ? value.left(4).toUInt() : value.toUInt();
-      songMetadataValues->date = v < 0 ? 0 : v;
-    } else if (line.startsWith(songMetadataGenreKey)) {
-      songMetadataValues->genre =
-          QString::fromUtf8(line.mid(songMetadataGenreKey.length()));
-    } else if (line.startsWith(songMetadataNameKey)) {
-      songMetadataValues->name =
-          QString::fromUtf8(line.mid(songMetadataNameKey.length()));
-    } else if (line.startsWith(songMetadataAlbumIdKey)) {
-      songMetadataValues->albumId =
-          QString::fromUtf8(line.mid(songMetadataAlbumIdKey.length()));
-    } else if (line.startsWith(songMetadataPerformerKey)) {
-      songMetadataValues->performer =
-          QString::fromUtf8(line.mid(songMetadataPerformerKey.length()));
-    } else if (line.startsWith(songMetadataCommentKey)) {
-      songMetadataValues->comment =
-          QString::fromUtf8(line.mid(songMetadataCommentKey.length()));
-    } else if (line.startsWith(songMetadataLastModifiedKey)) {
-      songMetadataValues->lastModified =
-          QString::fromUtf8(line.mid(songMetadataLastModifiedKey.length()));
-    } else if (line.startsWith(songMetadataPosKey)) {
-      songMetadataValues->pos =
-          QString::fromUtf8(line.mid(songMetadataPosKey.length())).toUInt();
+  Tokenizer tokenizer(data);
+  Token token;
+
+  while (tokenizer.next(&token)) {
+    switch (token.key) {
+      case Key::File:
+        songMetadataValues->file = toString(token);
+        break;
+      case Key::SongTime:
+        songMetadataValues->time = static_cast<quint16>(toNumber(token));
+        break;
+      case Key::Album:
+        songMetadataValues->album = toPooledString(token);
+        break;
+      case Key::Artist:
+        songMetadataValues->artist = toPooledString(token);
+        break;
+      case Key::AlbumArtist:
+        songMetadataValues->albumArtist = toPooledString(token);
+        break;
+      case Key::Composer:
+        songMetadataValues->composer = toPooledString(token);
+        break;
+      case Key::Title:
+        songMetadataValues->title = toString(token);
+        break;
+      case Key::Track: {
+        const qint64 v = toNumber(token);
+        songMetadataValues->track = v < 0 ? 0 : static_cast<quint16>(v);
+        break;
+      }
+      case Key::Id:
+        songMetadataValues->id = static_cast<qint32>(toNumber(token));
+        break;
+      case Key::Disc: {
+        const qint64 v = toNumber(token);
+        songMetadataValues->disc = v < 0 ? 0 : static_cast<quint8>(v);
+        break;
+      }
+      case Key::Date: {
+        // only the year of dates like 2004-05-01 or 20040501
+        const qint64 v = toNumber(token.value, qMin(token.length, 4));
+        songMetadataValues->date = v < 0 ? 0 : static_cast<quint16>(v);
+        break;
+      }
+      case Key::Genre:
+        songMetadataValues->genre = toPooledString(token);
+        break;
+      case Key::Name:
+        songMetadataValues->name = toString(token);
+        break;
+      case Key::AlbumId:
+        songMetadataValues->albumId = toString(token);
+        break;
+      case Key::Performer:
+        songMetadataValues->performer = toPooledString(token);
+        break;
+      case Key::Comment:
+        songMetadataValues->comment = toString(token);
+        break;
+      case Key::LastModified:
+        songMetadataValues->lastModified = toString(token);
+        break;
+      case Key::Pos:
+        songMetadataValues->pos = static_cast<uint>(toNumber(token));
+        break;
+      default:
+        break;
     }
   }
 }
 
-void MPDdataParser::parsePlaylistQueue(
-    const QByteArray &data, QList<MPDSongMetadata *> *playlistQueue) {
-  QList<QByteArray> songblock;
-  QList<QByteArray> lines = data.split('\n');
-  foreach (const QByteArray &line, lines) {
-    if (line == okValue) continue;
-
-    if (line.startsWith(songMetadataFileKey)) {
-      MPDSongMetadata *songmetadata = new MPDSongMetadata();
-      parseSongMetadata(songblock, songmetadata);
-      playlistQueue->append(songmetadata);
-      songblock.clear();
-    }
+void MPDdataParser::parsePlaylistQueue(const QByteArray &data,
+                                       QList<MPDSongMetadata> *playlistQueue) {
+  RecordStreamParser parser([playlistQueue](const QByteArray &record) {
+    MPDSongMetadata songmetadata;
+    parseSongMetadata(record, &songmetadata);
+    if (!songmetadata.file.isEmpty()) playlistQueue->append(songmetadata);
+  });
+  parser.feed(data);
+  parser.finish();
+}
 
-    if (!line.isEmpty()) songblock.append(line);
+void MPDdataParser::parseQueuePositions(const QByteArray &data,
+                                        QList<MPDSongMetadata> *songs) {
+  Tokenizer tokenizer(data);
+  Token token;
+  while (tokenizer.next(&token)) {
+    // every song starts with its position, its id follows
+    if (token.key == Key::Cpos) {
+      songs->append(MPDSongMetadata());
+      songs->last().pos = static_cast<uint>(toNumber(token));
+    } else if (token.key == Key::Id && !songs->isEmpty()) {
+      songs->last().id = static_cast<qint32>(toNumber(token));
+    }
   }
 }
 
-void MPDdataParser::parseFolderView(const QByteArray &data,
-                                    RootItem *rootitem) {
-  QList<QByteArray> lines = data.split('\n');
-
-  Item *currentDir = rootitem;
-  QStringList currentDirList;
-
-  int amountOfLines = lines.size();
-  for (int i = 0; i < amountOfLines; i++) {
-    QString line(lines.at(i));
-
-    if (line.startsWith("file: ")) {
-      line.remove(0, 6);
-      QStringList parts = line.split("/");
-
-      if (currentDir->type() == Item::Type::TypeRoot)
-        static_cast<RootItem *>(currentDir)
-            ->insertFile(parts.at(parts.size() - 1));
-      else
-        static_cast<FolderItem *>(currentDir)
-            ->insertFile(parts.at(parts.size() - 1));
-    } else if (line.startsWith("directory: ")) {
-      line.remove(0, 11);
-      QStringList parts = line.split("/");
-
-      /* Check how much matches */
-      int depth = 0;
-      for (int j = 0; j < currentDirList.size() && j < parts.size(); j++) {
-        if (currentDirList.at(j) != parts.at(j)) break;
-        depth++;
-      }
-
-      for (int j = currentDirList.size(); j > depth; j--) {
-        currentDir = currentDir->parent();
-      }
-
-      if (currentDir->type() == Item::Type::TypeRoot)
-        currentDir = static_cast<RootItem *>(currentDir)
-                         ->createDirectory(parts.at(parts.size() - 1));
-      else
-        currentDir = static_cast<FolderItem *>(currentDir)
-                         ->createDirectory(parts.at(parts.size() - 1));
-
-      currentDirList = parts;
+void MPDdataParser::parseDirectory(const QByteArray &data,
+                                   QStringList *directories,
+                                   QStringList *files) {
+  Tokenizer tokenizer(data);
+  Token token;
+  while (tokenizer.next(&token)) {
+    // stored playlists are shown along with the files
+    if (token.key != Key::Directory && token.key != Key::File &&
+        token.key != Key::Playlist)
+      continue;
+    // entries are listed by their path, the folder view shows their name
+    const char *const end = token.value + token.length;
+    const char *name = end;
+    while (name > token.value && name[-1] != '/') name--;
+    const QString entry = QString::fromUtf8(name, static_cast<int>(end - name));
+    if (token.key == Key::Directory) {
+      directories->append(entry);
+    } else {
+      files->append(entry);
     }
   }
 }
 
-void MPDdataParser::parseLibraryItems(
-    const QByteArray &data, QList<MusicLibraryItemArtist *> *artists) {
-  QList<QByteArray> currentItem;
-  MusicLibraryItemArtist *artistItem = nullptr;
-  MusicLibraryItemAlbum *albumItem = nullptr;
-  MusicLibraryItemSong *songItem = nullptr;
-  MPDSongMetadata *currentSong = nullptr;
-  bool found = false;
-
-  QList<QByteArray> lines = data.split('\n');
-  int amountOfLines = lines.size();
-
-  for (int i = 0; i < amountOfLines; i++) {
-    currentItem << lines.at(i);
-    if (i == lines.size() - 1 || lines.at(i + 1).startsWith("file:")) {
-          //qWarning () << lines.at(i);
-      currentSong = new MPDSongMetadata;
-      parseSongMetadata(currentItem, currentSong);
-      currentItem.clear();
-
-      int amountOfArtists = artists->size();
-
-      // Check if artist already exists
-      for (int i = 0; i < amountOfArtists; i++) {
-        if (artists->at(i)->data(0) == currentSong->artist) {
-          artistItem = static_cast<MusicLibraryItemArtist *>(artists->at(i));
-          found = true;
-        }
-      }
-
-      if (!found) {
-        artistItem = new MusicLibraryItemArtist(currentSong->artist);
-        artists->append(artistItem);
-      }
-
-      found = false;
-
-      int amountOfAlbums = artistItem->childCount();
-
-      // Check if album already exists
-      for (int i = 0; i < amountOfAlbums; i++) {
-        if (artistItem->child(i)->data(0) == currentSong->album) {
-          albumItem =
-              static_cast<MusicLibraryItemAlbum *>(artistItem->child(i));
-          found = true;
-        }
-      }
+MPDdataParser::RecordStreamParser::RecordStreamParser(
+    const RecordHandler &handler)
+    : handler_(handler) {}
+
+void MPDdataParser::RecordStreamParser::feed(const QByteArray &chunk) {
+  const char *const data = chunk.constData();
+  const char *const end = data + chunk.size();
+  const char *pos = data;
+  Token token;
+
+  // complete the line the last chunk ended in first, it may start a record
+  if (!pendingRecord_.isEmpty() && !pendingRecord_.endsWith('\n')) {
+    const char *eol = static_cast<const char *>(memchr(pos, '\n', end - pos));
+    if (!eol) {
+      pendingRecord_.append(chunk);
+      return;
+    }
+    const int lineStart = pendingRecord_.lastIndexOf('\n') + 1;
+    pendingRecord_.append(pos, eol + 1 - pos);
+    pos = eol + 1;
+
+    Tokenizer line(pendingRecord_.constData() + lineStart,
+                   pendingRecord_.size() - lineStart);
+    if (lineStart > 0 && line.next(&token) && isRecordStart(token.key)) {
+      handler_(QByteArray::fromRawData(pendingRecord_.constData(), lineStart));
+      pendingRecord_.remove(0, lineStart);
+    }
+  }
 
-      if (!found) {
-        albumItem = new MusicLibraryItemAlbum(currentSong->album, artistItem);
-        artistItem->appendChild(albumItem);
+  // only complete lines are tokenized, the partial last one is kept
+  const char *const linesEnd = data + chunk.lastIndexOf('\n') + 1;
+  const char *recordStart = pos;
+  if (linesEnd > pos) {
+    Tokenizer tokenizer(pos, linesEnd - pos);
+    while (tokenizer.next(&token)) {
+      if (!isRecordStart(token.key)) continue;
+
+      const char *line = tokenizer.line();
+      if (!pendingRecord_.isEmpty()) {
+        pendingRecord_.append(recordStart, line - recordStart);
+        handler_(pendingRecord_);
+        pendingRecord_.clear();
+      } else if (line > recordStart) {
+        handler_(QByteArray::fromRawData(recordStart, line - recordStart));
       }
+      recordStart = line;
+    }
+  }
+  pendingRecord_.append(recordStart, end - recordStart);
+}
 
-      found = false;
+void MPDdataParser::RecordStreamParser::finish() {
+  if (!pendingRecord_.isEmpty()) {
+    handler_(pendingRecord_);
+    pendingRecord_.clear();
+  }
+}
 
-      // Add song to album (possibly in track order)
-      songItem = new MusicLibraryItemSong(currentSong->title, albumItem);
-      songItem->setFile(currentSong->file);
-      songItem->setTrack(currentSong->track);
-      songItem->setDisc(currentSong->disc);
-      albumItem->appendChild(songItem);
+MPDdataParser::FolderViewBuilder::FolderViewBuilder(RootItem *rootitem)
+    : rootitem_(rootitem), currentDir_(rootitem) {}
 
-      delete currentSong;
-    }
+void MPDdataParser::FolderViewBuilder::addFile(const QString &path) {
+  const int slash = path.lastIndexOf('/');
+  const QStringRef dirPath = path.leftRef(qMax(slash, 0));
+  if (dirPath != currentDirPath_) {
+    currentDirPath_ = dirPath.toString();
+    currentDir_ = directory(currentDirPath_);
   }
+  currentDir_->insertFile(path.mid(slash + 1));
+}
+
+Item *MPDdataParser::FolderViewBuilder::directory(const QString &path) {
+  if (path.isEmpty()) return rootitem_;
+  const QHash<QString, Item *>::const_iterator it = dirs_.constFind(path);
+  if (it != dirs_.constEnd()) return it.value();
+
+  // the directories leading to it are created first
+  const int slash = path.lastIndexOf('/');
+  Item *const parent = directory(slash < 0 ? QString() : path.left(slash));
+  Item *const dir = parent->createDirectory(path.mid(slash + 1));
+  dirs_.insert(path, dir);
+  return dir;
 }
@@ -2,19 +2,69 @@
 #define MPDDATAPARSER_H
 #include "mpdmodel.h"
 
+#include <QHash>
+#include <QStringList>
+#include <functional>
+
+class Item;
 class RootItem;
-class MusicLibraryItemArtist;
 
 namespace MPDdataParser {
+// Push parser for record based replies (listall, listallinfo, playlistinfo,
+// plchanges).
+// Bytes are fed as they arrive, a record is handed out as soon as the line
+// starting the next one shows it is complete, so at most one partial record
+// is buffered. Records that arrive within one chunk are not copied, the
+// QByteArray handed out only stays valid during the call.
+class RecordStreamParser {
+ public:
+  typedef std::function<void(const QByteArray &record)> RecordHandler;
+
+  explicit RecordStreamParser(const RecordHandler &handler);
+  void feed(const QByteArray &chunk);
+  // hands out the last record, call once the reply is complete
+  void finish();
+
+ private:
+  RecordHandler handler_;
+  // the record that is still incomplete at the end of the last chunk
+  QByteArray pendingRecord_;
+};
+
+// Builds a folder tree from the paths of all files. Directories
+// are looked up by their path prefix, so files may come in any order & a
+// run of files in one directory costs a single comparison each.
+class FolderViewBuilder {
+ public:
+  // The folders are left unfetched, they may hold more than the files
+  // added, like folders without songs & stored playlists
+  explicit FolderViewBuilder(RootItem *rootitem);
+  // Adds the file & the directories leading to it
+  void addFile(const QString &path);
+
+ private:
+  RootItem *const rootitem_;
+  // the directory of the last file
+  Item *currentDir_;
+  QString currentDirPath_;
+  // every directory created so far by its path
+  QHash<QString, Item *> dirs_;
+
+  Item *directory(const QString &path);
+};
+
 void parseStatus(const QByteArray &data, MPDStatusValues *statusValues);
 void parseStats(const QByteArray &data, MPDStatsValues *statsValues);
-void parseSongMetadata(const QList<QByteArray> &data,
+void parseSongMetadata(const QByteArray &data,
                        MPDSongMetadata *songMetadataValues);
 void parsePlaylistQueue(const QByteArray &data,
-                        QList<MPDSongMetadata *> *playlistQueue);
-void parseFolderView(const QByteArray &data, RootItem *rootitem);
-void parseLibraryItems(const QByteArray &data,
-                       QList<MusicLibraryItemArtist *> *artists);
+                        QList<MPDSongMetadata> *playlistQueue);
+// the positions & ids of a plchangesposid reply, the rest is left unset
+void parseQueuePositions(const QByteArray &data,
+                         QList<MPDSongMetadata> *songs);
+// the names of the directories & of the files & playlists of an lsinfo reply
+void parseDirectory(const QByteArray &data, QStringList *directories,
+                    QStringList *files);
 }  // namespace MPDdataParser
 
 #endif  // MPDDATAPARSER_H
@@ -4,10 +4,24 @@ Item::Item(const QString name, Type type) : name_(name), type_(type) {}
 
 Item::~Item() {}
 
-FolderItem::FolderItem(const QString name, Item *parent)
-    : Item(name, Item::Type::TypeFolder), parentItem_(parent) {}
+QString Item::path() const {
+  QString path = name_;
+  for (const Item *current = parent();
+       current && current->type() != Item::Type::TypeRoot;
+       current = current->parent()) {
+    path.prepend("/");
+    path.prepend(current->name());
+  }
+  return type_ == Item::Type::TypeRoot ? QString() : path;
+}
+
+FolderItem::FolderItem(const QString name, MPDArena *arena, Item *parent)
+    : Item(name, Item::Type::TypeFolder),
+      parentItem_(parent),
+      arena_(arena),
+      fetched_(false) {}
 
-FolderItem::~FolderItem() { qDeleteAll(childItems_); }
+FolderItem::~FolderItem() {}
 
 int FolderItem::row() const {
   switch (parentItem_->type()) {
@@ -29,14 +43,14 @@ Item *FolderItem::parent() const { return parentItem_; }
 int FolderItem::childCount() const { return childItems_.count(); }
 
 Item *FolderItem::createDirectory(const QString dirName) {
-  FolderItem *dir = new FolderItem(dirName, this);
+  FolderItem *dir = arena_->create<FolderItem>(dirName, arena_, this);
   childItems_.append(dir);
 
   return dir;
 }
 
 Item *FolderItem::insertFile(const QString fileName) {
-  FileItem *file = new FileItem(fileName, this);
+  FileItem *file = arena_->create<FileItem>(fileName, this);
   childItems_.append(file);
 
   return file;
@@ -66,33 +80,24 @@ int FileItem::row() const {
 
 Item *FileItem::parent() const { return parentItem_; }
 
-QString FileItem::fileName() {
-  QString filename = name_;
-
-  Item *current = this->parent();
-  while (current->type() != Item::Type::TypeRoot) {
-    filename.prepend("/");
-    filename.prepend(current->name());
-    current = current->parent();
-  }
-  return filename;
-}
+QString FileItem::fileName() { return path(); }
 
-RootItem::RootItem(const QString name) : Item(name, Item::Type::TypeRoot) {}
+RootItem::RootItem(const QString name)
+    : Item(name, Item::Type::TypeRoot), fetched_(false) {}
 
-RootItem::~RootItem() { qDeleteAll(childItems_); }
+RootItem::~RootItem() {}
 
 int RootItem::childCount() const { return childItems_.count(); }
 
 Item *RootItem::createDirectory(const QString dirName) {
-  FolderItem *dir = new FolderItem(dirName, this);
+  FolderItem *dir = arena_.create<FolderItem>(dirName, &arena_, this);
   childItems_.append(dir);
 
   return dir;
 }
 
 Item *RootItem::insertFile(const QString fileName) {
-  FileItem *file = new FileItem(fileName, this);
+  FileItem *file = arena_.create<FileItem>(fileName, this);
   childItems_.append(file);
 
   return file;
@@ -101,6 +106,7 @@ Item *RootItem::insertFile(const QString fileName) {
 Item *RootItem::child(int row) const { return childItems_.value(row); }
 
 void RootItem::clear() {
-  qDeleteAll(childItems_.begin(), childItems_.end());
   childItems_.clear();
+  arena_.clear();
+  fetched_ = false;
 }
@@ -4,6 +4,8 @@
 #include <QString>
 #include <QVariant>
 
+#include "mpdarena.h"
+
 class Item {
  public:
   enum class Type { TypeRoot, TypeFolder, TypeFile };
@@ -17,22 +19,34 @@ class Item {
   int columnCount() const { return 1; }
   QVariant data(int) const { return name_; }
   virtual Item* child(int /*row*/) const { return nullptr; }
-  QString name() { return name_; }
+  QString name() const { return name_; }
   Item::Type type() const { return type_; }
   virtual QString fileName() { return QString(); }
+  // folders & the root hold children, files don't
+  virtual Item* createDirectory(const QString /*dirName*/) { return nullptr; }
+  virtual Item* insertFile(const QString /*fileName*/) { return nullptr; }
+  // false while the children have yet to be fetched from MPD
+  virtual bool isFetched() const { return true; }
+  virtual void setFetched(const bool /*fetched*/) {}
+  // the path below the music directory, empty for the root
+  QString path() const;
 
  protected:
   QString name_;
   Type type_;
 };
 
+// Folders & files are allocated from the arena of their RootItem & go with
+// it, they don't delete their children.
 class FolderItem : public Item {
  public:
-  FolderItem(const QString name, Item* parent = nullptr);
+  FolderItem(const QString name, MPDArena* arena, Item* parent = nullptr);
   ~FolderItem();
 
   Item* createDirectory(const QString dirName);
   Item* insertFile(const QString fileName);
+  bool isFetched() const { return fetched_; }
+  void setFetched(const bool fetched) { fetched_ = fetched; }
 
   int row() const;
   Item* parent() const;
@@ -41,7 +55,9 @@ class FolderItem : public Item {
 
  private:
   Item* const parentItem_;
+  MPDArena* const arena_;
   QList<Item*> childItems_;
+  bool fetched_;
 
   friend class FileItem;
 };
@@ -66,6 +82,8 @@ class RootItem : public Item {
 
   Item* createDirectory(const QString dirName);
   Item* insertFile(const QString fileName);
+  bool isFetched() const { return fetched_; }
+  void setFetched(const bool fetched) { fetched_ = fetched; }
 
   int childCount() const;
   Item* child(int row) const;
@@ -73,6 +91,9 @@ class RootItem : public Item {
 
  private:
   QList<Item*> childItems_;
+  bool fetched_;
+  // all items below the root, released at once
+  MPDArena arena_;
 
   friend class FolderItem;
   friend class FileItem;
@@ -0,0 +1,117 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mpdidlelistener.h"
+#include "mpdsocket.h"
+
+#include <QDebug>
+
+const QByteArray MPDIdleListener::idleCmd =
+    "idle player mixer options playlist database stored_playlist";
+const QByteArray MPDIdleListener::noidleCmd = "noidle";
+
+// MPD idle look up keys & values
+static const QByteArray changedKey("changed: ");
+static const QByteArray playerValue("player");
+static const QByteArray mixerValue("mixer");
+static const QByteArray optionsValue("options");
+static const QByteArray playlistValue("playlist");
+static const QByteArray databaseValue("database");
+static const QByteArray storedPlaylistValue("stored_playlist");
+
+MPDIdleListener::MPDIdleListener(QObject *parent,
+                                 std::shared_ptr<MPDSocket> idleSocket)
+    : QObject(parent),
+      idleSocket_(idleSocket),
+      active_(false),
+      idlePending_(false) {}
+
+MPDIdleListener::~MPDIdleListener() {}
+
+void MPDIdleListener::start() {
+  if (active_) return;
+  if (!idleSocket_->isConnected()) {
+    qWarning() << "idle connection not available, falling back to polling";
+    emit unavailable();
+    return;
+  }
+
+  active_ = true;
+  idle();
+}
+
+void MPDIdleListener::stop() {
+  active_ = false;
+  // noidle has no reply of its own, it makes MPD answer the pending idle
+  // right away, so it is written around the command queue
+  if (idlePending_ && idleSocket_->isConnected()) {
+    idleSocket_->writeCommand(noidleCmd);
+  }
+}
+
+void MPDIdleListener::idle() {
+  if (idlePending_) return;
+
+  idlePending_ = true;
+  idleSocket_->sendCommand(idleCmd, [this](const QPair<QByteArray, bool>
+                                               &reply) {
+    idlePending_ = false;
+    if (!active_) return;
+
+    if (!reply.second) {
+      active_ = false;
+      if (reply.first.isEmpty()) {
+        qWarning() << "idle connection lost, falling back to polling";
+      } else {
+        qWarning() << "idle not supported, falling back to polling"
+                   << reply.first;
+      }
+      emit unavailable();
+      return;
+    }
+
+    // park the connection again before handling the change so no event
+    // can be missed in between
+    idle();
+
+    const Subsystems subsystems = parseChanged(reply.first);
+    if (subsystems != None) emit changed(subsystems);
+  });
+}
+
+MPDIdleListener::Subsystems MPDIdleListener::parseChanged(
+    const QByteArray &data) {
+  Subsystems subsystems = None;
+  foreach (const QByteArray &line, data.split('\n')) {
+    if (!line.startsWith(changedKey)) continue;
+
+    const QByteArray value = line.mid(changedKey.length());
+    if (value == playerValue) {
+      subsystems |= Player;
+    } else if (value == mixerValue) {
+      subsystems |= Mixer;
+    } else if (value == optionsValue) {
+      subsystems |= Options;
+    } else if (value == playlistValue) {
+      subsystems |= Playlist;
+    } else if (value == databaseValue) {
+      subsystems |= Database;
+    } else if (value == storedPlaylistValue) {
+      subsystems |= StoredPlaylist;
+    }
+  }
+  return subsystems;
+}
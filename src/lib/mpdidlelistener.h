@@ -0,0 +1,74 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MPDIDLELISTENER_H
+#define MPDIDLELISTENER_H
+
+#include <QObject>
+#include <atomic>
+#include <memory>
+
+class MPDSocket;
+
+// Keeps a dedicated connection parked in "idle" & reports which MPD
+// subsystems changed, so data is only refetched when something happened.
+// https://www.musicpd.org/doc/protocol/command_reference.html#status_commands
+class MPDIdleListener : public QObject {
+  Q_OBJECT
+ public:
+  enum Subsystem {
+    None = 0x00,
+    Player = 0x01,
+    Mixer = 0x02,
+    Options = 0x04,
+    Playlist = 0x08,
+    Database = 0x10,
+    StoredPlaylist = 0x20,
+  };
+  Q_DECLARE_FLAGS(Subsystems, Subsystem)
+
+  explicit MPDIdleListener(QObject *parent = nullptr,
+                           std::shared_ptr<MPDSocket> idleSocket = nullptr);
+  ~MPDIdleListener();
+
+  inline bool isActive() const { return active_; }
+
+ public slots:
+  void start();
+  void stop();
+
+ signals:
+  void changed(MPDIdleListener::Subsystems subsystems);
+  // idle is not supported by the server or the idle connection was lost,
+  // callers should fall back to polling
+  void unavailable();
+
+ private:
+  std::shared_ptr<MPDSocket> idleSocket_;
+  // isActive() is also asked from the GUI thread
+  std::atomic<bool> active_;
+  bool idlePending_;
+
+  void idle();
+  static Subsystems parseChanged(const QByteArray &data);
+
+  const static QByteArray idleCmd;
+  const static QByteArray noidleCmd;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(MPDIdleListener::Subsystems)
+
+#endif  // MPDIDLELISTENER_H
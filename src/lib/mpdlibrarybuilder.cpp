@@ -0,0 +1,195 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "mpdlibrarybuilder.h"
+#include "mpdmodel.h"
+
+#include <QSettings>
+#include <QVector>
+
+#include <algorithm>
+
+namespace {
+// A tree item with the key it is sorted by
+template <typename Item>
+struct SortEntry {
+  QString name;
+  quint16 date;
+  Item *item;
+};
+
+// case insensitive, ties broken case sensitively so the order is total
+inline int compareNames(const QString &a, const QString &b) {
+  const int compared = QString::compare(a, b, Qt::CaseInsensitive);
+  return compared != 0 ? compared : QString::compare(a, b);
+}
+
+// The order of the songs of an album, titles are rarely compared as the
+// songs mostly differ in disc or track
+bool songLessThan(const MPDSongTable *songs, const MPDSongMetadata &a,
+                  const quint32 b) {
+  if (a.disc != songs->disc(b)) return a.disc < songs->disc(b);
+  // unnumbered songs last
+  const quint32 trackA = a.track ? a.track : 0x10000;
+  const quint32 trackB = songs->track(b) ? songs->track(b) : 0x10000;
+  if (trackA != trackB) return trackA < trackB;
+  const int compared = compareNames(a.title, songs->title(b));
+  if (compared != 0) return compared < 0;
+  return a.file < songs->file(b);
+}
+}  // namespace
+
+MusicLibraryBuilder::MusicLibraryBuilder(MusicLibraryItemRoot *root)
+    : root_(root) {}
+
+MusicLibraryItemArtist *MusicLibraryBuilder::artist(
+    const QString &name) const {
+  return artists_.value(name, nullptr);
+}
+
+MusicLibraryItemAlbum *MusicLibraryBuilder::album(
+    const MusicLibraryItemArtist *artist, const QString &title) const {
+  return albums_.value(AlbumKey(artist, title), nullptr);
+}
+
+MusicLibraryItemArtist *MusicLibraryBuilder::addArtist(const QString &name) {
+  MusicLibraryItemArtist *artistItem =
+      root_->arena()->create<MusicLibraryItemArtist>(name, root_);
+  rows_.insert(artistItem, root_->childCount());
+  root_->appendChild(artistItem);
+  artists_.insert(name, artistItem);
+  return artistItem;
+}
+
+MusicLibraryItemAlbum *MusicLibraryBuilder::addAlbum(
+    MusicLibraryItemArtist *artist, const QString &title) {
+  MusicLibraryItemAlbum *albumItem =
+      root_->arena()->create<MusicLibraryItemAlbum>(title, artist);
+  rows_.insert(albumItem, artist->childCount());
+  artist->appendChild(albumItem);
+  albums_.insert(AlbumKey(artist, title), albumItem);
+  return albumItem;
+}
+
+MusicLibraryItemSong *MusicLibraryBuilder::addSong(
+    MusicLibraryItemAlbum *album, const MPDSongMetadata &song) {
+  const int row = songRow(album, song);
+  MPDSongTable *const songs = root_->songs();
+  MusicLibraryItemSong *songItem = root_->arena()->create<MusicLibraryItemSong>(
+      songs, songs->append(song), album);
+  album->m_childItems.insert(row, songItem);
+  return songItem;
+}
+
+int MusicLibraryBuilder::songRow(const MusicLibraryItemAlbum *album,
+                                 const MPDSongMetadata &song) const {
+  // after the songs it ties with, songs mostly arrive in order & go last
+  const QList<MusicLibraryItemSong *> &albumSongs = album->m_childItems;
+  if (albumSongs.isEmpty() ||
+      !songLessThan(root_->songs(), song, albumSongs.last()->song())) {
+    return albumSongs.size();
+  }
+  const MPDSongTable *const songs = root_->songs();
+  return static_cast<int>(
+      std::upper_bound(albumSongs.begin(), albumSongs.end(), song,
+                       [songs](const MPDSongMetadata &a,
+                               const MusicLibraryItemSong *b) {
+                         return songLessThan(songs, a, b->song());
+                       }) -
+      albumSongs.begin());
+}
+
+void MusicLibraryBuilder::addSongs(MusicLibraryItemAlbum *album,
+                                   const QList<MPDSongMetadata> &songs,
+                                   const int first, const int last) {
+  for (int i = first; i < last; i++) addSong(album, songs.at(i));
+}
+
+int MusicLibraryBuilder::row(const MusicLibraryItemArtist *artist) const {
+  return rows_.value(artist, -1);
+}
+
+int MusicLibraryBuilder::row(const MusicLibraryItemAlbum *album) const {
+  return rows_.value(album, -1);
+}
+
+void MusicLibraryBuilder::sort() {
+  sortAlbums(albumOrder());
+
+  QVector<SortEntry<MusicLibraryItemArtist>> artists;
+  artists.reserve(root_->m_childItems.size());
+  for (MusicLibraryItemArtist *artist : root_->m_childItems) {
+    artists.append({artist->data(0).toString(), 0, artist});
+  }
+  std::sort(artists.begin(), artists.end(),
+            [](const SortEntry<MusicLibraryItemArtist> &a,
+               const SortEntry<MusicLibraryItemArtist> &b) {
+              return compareNames(a.name, b.name) < 0;
+            });
+  for (int i = 0; i < artists.size(); i++) {
+    root_->m_childItems[i] = artists.at(i).item;
+  }
+  rows_.clear();
+}
+
+void MusicLibraryBuilder::sortAlbums(const AlbumOrder order) {
+  const MPDSongTable *const songs = root_->songs();
+  for (MusicLibraryItemArtist *artist : root_->m_childItems) {
+    QVector<SortEntry<MusicLibraryItemAlbum>> albums;
+    albums.reserve(artist->m_childItems.size());
+    for (MusicLibraryItemAlbum *album : artist->m_childItems) {
+      // an album dates from its earliest dated song
+      quint16 date = 0;
+      if (order == AlbumOrder::Date) {
+        for (const MusicLibraryItemSong *song : album->m_childItems) {
+          const quint16 songDate = songs->date(song->song());
+          if (songDate != 0 && (date == 0 || songDate < date)) {
+            date = songDate;
+          }
+        }
+      }
+      albums.append({album->data(0).toString(), date, album});
+    }
+
+    std::sort(albums.begin(), albums.end(),
+              [order](const SortEntry<MusicLibraryItemAlbum> &a,
+                      const SortEntry<MusicLibraryItemAlbum> &b) {
+                // undated albums after the dated ones
+                if (order == AlbumOrder::Date && a.date != b.date) {
+                  return a.date != 0 && (b.date == 0 || a.date < b.date);
+                }
+                return compareNames(a.name, b.name) < 0;
+              });
+    for (int i = 0; i < albums.size(); i++) {
+      artist->m_childItems[i] = albums.at(i).item;
+    }
+  }
+  rows_.clear();
+}
+
+MusicLibraryBuilder::AlbumOrder MusicLibraryBuilder::albumOrder() {
+  QSettings settings;
+  return settings.value("library-album-order", "title").toString() == "date"
+             ? AlbumOrder::Date
+             : AlbumOrder::Title;
+}
+
+void MusicLibraryBuilder::setAlbumOrder(const AlbumOrder order) {
+  QSettings settings;
+  settings.setValue("library-album-order",
+                    order == AlbumOrder::Date ? "date" : "title");
+}
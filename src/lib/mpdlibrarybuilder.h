@@ -0,0 +1,81 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MPDLIBRARYBUILDER_H
+#define MPDLIBRARYBUILDER_H
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QString>
+
+#include "mpdlibrarymodel.h"
+
+struct MPDSongMetadata;
+
+// Builds the artist/album/song tree below an empty root. Artists & albums
+// are looked up in hash indexes instead of scanning the tree, so building
+// takes time linear in the number of songs.
+class MusicLibraryBuilder {
+ public:
+  // how sort() orders the albums of an artist, the library-album-order
+  // setting ("title" or "date")
+  enum class AlbumOrder { Title, Date };
+
+  explicit MusicLibraryBuilder(MusicLibraryItemRoot *root);
+
+  // nullptr if not added yet
+  MusicLibraryItemArtist *artist(const QString &name) const;
+  MusicLibraryItemAlbum *album(const MusicLibraryItemArtist *artist,
+                               const QString &title) const;
+  MusicLibraryItemArtist *addArtist(const QString &name);
+  MusicLibraryItemAlbum *addAlbum(MusicLibraryItemArtist *artist,
+                                  const QString &title);
+  // Adds the song to the song table of the root & to album, where it goes
+  // in the row songRow() reports beforehand. The songs of an album are
+  // kept in disc, track (unnumbered ones last), title & file order.
+  MusicLibraryItemSong *addSong(MusicLibraryItemAlbum *album,
+                                const MPDSongMetadata &song);
+  int songRow(const MusicLibraryItemAlbum *album,
+              const MPDSongMetadata &song) const;
+  // adds songs [first, last) to album
+  void addSongs(MusicLibraryItemAlbum *album,
+                const QList<MPDSongMetadata> &songs, const int first,
+                const int last);
+
+  // Rows of the items added so far, without searching their parent
+  int row(const MusicLibraryItemArtist *artist) const;
+  int row(const MusicLibraryItemAlbum *album) const;
+
+  // Orders the artists by name & their albums by the album order setting
+  // once the tree is built. The tree order is then the order songs are
+  // shown & queued in. The rows above are void afterwards.
+  void sort();
+  // orders the albums of every artist only, when the setting changed
+  void sortAlbums(AlbumOrder order);
+  static AlbumOrder albumOrder();
+  static void setAlbumOrder(AlbumOrder order);
+
+ private:
+  typedef QPair<const MusicLibraryItemArtist *, QString> AlbumKey;
+
+  MusicLibraryItemRoot *root_;
+  QHash<QString, MusicLibraryItemArtist *> artists_;
+  QHash<AlbumKey, MusicLibraryItemAlbum *> albums_;
+  QHash<const MusicLibraryItem *, int> rows_;
+};
+
+#endif  // MPDLIBRARYBUILDER_H
@@ -0,0 +1,355 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mpdlibrarycache.h"
+#include "mpdlibrarybuilder.h"
+#include "mpdlibrarymodel.h"
+#include "mpdmodel.h"
+#include "mpdstringpool.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QSaveFile>
+#include <QVector>
+
+#include <cstring>
+
+namespace {
+
+const char magic[8] = {'T', 'O', 'D', 'I', 'L', 'I', 'B', '\0'};
+// bump on every change of the layout below
+const quint32 version = 2;
+// written natively, a cache of the other byte order is rebuilt
+const quint32 byteOrder = 0x01020304;
+
+struct Header {
+  char magic[8];
+  quint32 version;
+  quint32 byteOrder;
+  qint64 dbUpdate;
+  quint32 songCount;
+  quint32 stringCount;
+  // the MusicLibraryBuilder::AlbumOrder the albums of an artist follow
+  quint32 albumOrder;
+  quint32 reserved;
+};
+
+// flags of a song record
+enum : quint8 { ArtistStart = 1, AlbumStart = 2 };
+
+// strings are indexes into the string table, 0 is the empty string
+struct SongRecord {
+  quint32 file;
+  quint32 artist;
+  quint32 album;
+  quint32 albumId;
+  quint32 albumArtist;
+  quint32 title;
+  quint32 name;
+  quint32 genre;
+  quint32 composer;
+  quint32 performer;
+  quint32 comment;
+  quint32 lastModified;
+  quint16 track;
+  quint16 date;
+  quint16 time;
+  quint8 disc;
+  quint8 flags;
+};
+
+static_assert(sizeof(Header) == 40, "cache header must not be padded");
+static_assert(sizeof(SongRecord) == 56, "song record must not be padded");
+
+// Collects the distinct strings of the records
+class StringTable {
+ public:
+  StringTable() { id(QString()); }
+
+  quint32 id(const QString &string) {
+    const QHash<QString, quint32>::const_iterator it = ids_.constFind(string);
+    if (it != ids_.constEnd()) return it.value();
+
+    const quint32 id = static_cast<quint32>(strings_.size());
+    ids_.insert(string, id);
+    strings_.append(string);
+    return id;
+  }
+  const QVector<QString> &strings() const { return strings_; }
+
+ private:
+  QHash<QString, quint32> ids_;
+  QVector<QString> strings_;
+};
+
+bool isValid(const SongRecord &record, const quint32 stringCount) {
+  const quint32 strings[] = {
+      record.file,        record.artist,   record.album, record.albumId,
+      record.albumArtist, record.title,    record.name,  record.genre,
+      record.composer,    record.performer, record.comment,
+      record.lastModified};
+  for (const quint32 string : strings) {
+    if (string >= stringCount) return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+MPDLibraryCache::MPDLibraryCache(const QString &host) {
+  // the host may be the path of a socket
+  QString name = host;
+  for (QChar &c : name) {
+    if (!c.isLetterOrNumber() && c != '.' && c != '-') c = '_';
+  }
+  fileName_ = QDir::homePath() + "/.QtMPC/" + name + "_library.cache";
+}
+
+MPDLibraryCache::Order MPDLibraryCache::order(
+    const MusicLibraryItemRoot *root) {
+  Order order;
+  order.songs.reserve(root->songs()->size());
+  order.albums = MusicLibraryBuilder::albumOrder();
+  for (int i = 0; i < root->childCount(); i++) {
+    const MusicLibraryItem *const artist = root->child(i);
+    for (int j = 0; j < artist->childCount(); j++) {
+      const MusicLibraryItem *const album = artist->child(j);
+      for (int k = 0; k < album->childCount(); k++) {
+        order.songs.append(
+            static_cast<const MusicLibraryItemSong *>(album->child(k))
+                ->song());
+      }
+    }
+  }
+  return order;
+}
+
+bool MPDLibraryCache::write(const MusicLibraryItemRoot *root,
+                            const Order &order,
+                            const QDateTime &dbUpdate) const {
+  if (!QDir::home().mkpath(".QtMPC")) {
+    qWarning() << "Couldn't create directory for storing the library cache";
+    return false;
+  }
+
+  const MPDSongTable *const songs = root->songs();
+  StringTable strings;
+  QVector<SongRecord> records;
+  records.reserve(order.songs.size());
+
+  // In the order the tree shows the songs, so reading them back builds the
+  // tree as it is. Only the song table is read, the tree may be reordered in
+  // the GUI thread meanwhile. An artist or album starts where the song's
+  // differs from the one before, pooled values compare by their data first.
+  const QString *artist = nullptr;
+  const QString *album = nullptr;
+  for (const quint32 song : order.songs) {
+    if (song >= static_cast<quint32>(songs->size())) return false;
+    const QString &songArtist = songs->tag(MPDSongTable::Tag::Artist, song);
+    const QString &songAlbum = songs->tag(MPDSongTable::Tag::Album, song);
+    SongRecord record;
+    record.flags = 0;
+    if (!artist || songArtist != *artist) {
+      record.flags |= ArtistStart | AlbumStart;
+    } else if (songAlbum != *album) {
+      record.flags |= AlbumStart;
+    }
+    artist = &songArtist;
+    album = &songAlbum;
+
+    record.file = strings.id(songs->file(song));
+    record.artist = strings.id(songArtist);
+    record.album = strings.id(songAlbum);
+    record.albumId = strings.id(songs->albumId(song));
+    record.albumArtist =
+        strings.id(songs->tag(MPDSongTable::Tag::AlbumArtist, song));
+    record.title = strings.id(songs->title(song));
+    record.name = strings.id(songs->name(song));
+    record.genre = strings.id(songs->tag(MPDSongTable::Tag::Genre, song));
+    record.composer = strings.id(songs->tag(MPDSongTable::Tag::Composer, song));
+    record.performer =
+        strings.id(songs->tag(MPDSongTable::Tag::Performer, song));
+    record.comment = strings.id(songs->comment(song));
+    record.lastModified = strings.id(songs->lastModified(song));
+    record.track = songs->track(song);
+    record.date = songs->date(song);
+    record.time = songs->time(song);
+    record.disc = songs->disc(song);
+    records.append(record);
+  }
+
+  // offsets of the strings in UTF-16 code units, the last one is the end
+  QVector<quint32> offsets;
+  offsets.reserve(strings.strings().size() + 1);
+  quint32 offset = 0;
+  for (const QString &string : strings.strings()) {
+    offsets.append(offset);
+    offset += static_cast<quint32>(string.size());
+  }
+  offsets.append(offset);
+
+  Header header;
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.version = version;
+  header.byteOrder = byteOrder;
+  header.dbUpdate = dbUpdate.toMSecsSinceEpoch();
+  header.songCount = static_cast<quint32>(records.size());
+  header.stringCount = static_cast<quint32>(strings.strings().size());
+  header.albumOrder = static_cast<quint32>(order.albums);
+  header.reserved = 0;
+
+  QSaveFile file(fileName_);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qWarning() << "Couldn't write the library cache" << fileName_;
+    return false;
+  }
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(records.constData()),
+             records.size() * sizeof(SongRecord));
+  file.write(reinterpret_cast<const char *>(offsets.constData()),
+             offsets.size() * sizeof(quint32));
+  for (const QString &string : strings.strings()) {
+    file.write(reinterpret_cast<const char *>(string.constData()),
+               string.size() * sizeof(QChar));
+  }
+  return file.commit();
+}
+
+MusicLibraryItemRoot *MPDLibraryCache::read(QDateTime *dbUpdate) const {
+  QFile file(fileName_);
+  if (!file.open(QIODevice::ReadOnly)) return nullptr;
+
+  const qint64 size = file.size();
+  if (size < static_cast<qint64>(sizeof(Header))) return nullptr;
+  const uchar *const data = file.map(0, size);
+  if (!data) return nullptr;
+
+  const Header *const header = reinterpret_cast<const Header *>(data);
+  if (std::memcmp(header->magic, magic, sizeof(magic)) != 0 ||
+      header->version != version || header->byteOrder != byteOrder) {
+    qInfo() << "Ignoring library cache of another format" << fileName_;
+    return nullptr;
+  }
+
+  const qint64 recordsSize =
+      static_cast<qint64>(header->songCount) * sizeof(SongRecord);
+  const qint64 offsetsSize =
+      (static_cast<qint64>(header->stringCount) + 1) * sizeof(quint32);
+  if (header->stringCount == 0 ||
+      size < static_cast<qint64>(sizeof(Header)) + recordsSize + offsetsSize) {
+    return nullptr;
+  }
+  const SongRecord *const records =
+      reinterpret_cast<const SongRecord *>(data + sizeof(Header));
+  const quint32 *const offsets = reinterpret_cast<const quint32 *>(
+      data + sizeof(Header) + recordsSize);
+  const QChar *const chars = reinterpret_cast<const QChar *>(
+      data + sizeof(Header) + recordsSize + offsetsSize);
+  const qint64 charsSize = size - sizeof(Header) - recordsSize - offsetsSize;
+  if (static_cast<qint64>(offsets[header->stringCount]) * sizeof(QChar) >
+      charsSize) {
+    return nullptr;
+  }
+
+  for (quint32 i = 0; i < header->stringCount; i++) {
+    if (offsets[i] > offsets[i + 1]) return nullptr;
+  }
+
+  // Every distinct string is taken out of the mapping once, when first
+  // referred to. Tag values go through the pool, like those MPD sends, so
+  // the song table tells them apart by their data.
+  QVector<QString> strings(static_cast<int>(header->stringCount));
+  QVector<bool> pooled(static_cast<int>(header->stringCount), false);
+  const auto string = [&strings, chars, offsets](const quint32 i) {
+    QString &copied = strings[static_cast<int>(i)];
+    if (copied.isNull() && i != 0) {
+      copied = QString(chars + offsets[i],
+                       static_cast<int>(offsets[i + 1] - offsets[i]));
+    }
+    return copied;
+  };
+  const auto tag = [&strings, &pooled, chars, offsets](const quint32 i) {
+    QString &interned = strings[static_cast<int>(i)];
+    if (i == 0 || pooled.at(static_cast<int>(i))) return interned;
+    const QByteArray utf8 =
+        QString::fromRawData(chars + offsets[i],
+                             static_cast<int>(offsets[i + 1] - offsets[i]))
+            .toUtf8();
+    pooled[static_cast<int>(i)] = true;
+    interned = MPDStringPool::instance().intern(utf8.constData(), utf8.size());
+    return interned;
+  };
+
+  MusicLibraryItemRoot *const root =
+      new MusicLibraryItemRoot("Artist / Album / Song");
+  MPDSongTable *const songs = root->songs();
+  songs->reserve(static_cast<int>(header->songCount));
+  MPDArena *const arena = root->arena();
+  MusicLibraryItemArtist *artistItem = nullptr;
+  MusicLibraryItemAlbum *albumItem = nullptr;
+
+  // The records are in tree order, every item is appended where it goes
+  // without looking it up or sorting afterwards
+  for (quint32 i = 0; i < header->songCount; i++) {
+    const SongRecord &record = records[i];
+    if (!isValid(record, header->stringCount)) {
+      delete root;
+      return nullptr;
+    }
+
+    if (!artistItem || (record.flags & ArtistStart)) {
+      artistItem =
+          arena->create<MusicLibraryItemArtist>(tag(record.artist), root);
+      root->appendChild(artistItem);
+      albumItem = nullptr;
+    }
+    if (!albumItem || (record.flags & AlbumStart)) {
+      albumItem =
+          arena->create<MusicLibraryItemAlbum>(tag(record.album), artistItem);
+      artistItem->appendChild(albumItem);
+    }
+
+    MPDSongMetadata song;
+    song.file = string(record.file);
+    song.artist = tag(record.artist);
+    song.album = tag(record.album);
+    song.albumId = string(record.albumId);
+    song.albumArtist = tag(record.albumArtist);
+    song.title = string(record.title);
+    song.track = record.track;
+    song.name = string(record.name);
+    song.genre = tag(record.genre);
+    song.date = record.date;
+    song.composer = tag(record.composer);
+    song.performer = tag(record.performer);
+    song.comment = string(record.comment);
+    song.disc = record.disc;
+    song.time = record.time;
+    song.lastModified = string(record.lastModified);
+    albumItem->appendChild(arena->create<MusicLibraryItemSong>(
+        songs, songs->append(song), albumItem));
+  }
+  // only the albums need reordering, if the setting changed since
+  const MusicLibraryBuilder::AlbumOrder albumOrder =
+      MusicLibraryBuilder::albumOrder();
+  if (header->albumOrder != static_cast<quint32>(albumOrder)) {
+    MusicLibraryBuilder(root).sortAlbums(albumOrder);
+  }
+  *dbUpdate = QDateTime::fromMSecsSinceEpoch(header->dbUpdate);
+  return root;
+}
@@ -0,0 +1,60 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MPDLIBRARYCACHE_H
+#define MPDLIBRARYCACHE_H
+
+#include <QDateTime>
+#include <QMetaType>
+#include <QString>
+#include <QVector>
+
+#include "mpdlibrarybuilder.h"
+
+// The library stored on disk between runs. A versioned binary file that is
+// memory mapped & turned into a library without parsing: a header, one
+// fixed width record per song in the order the tree shows them, the first
+// song of every artist & album flagged, & a table of the distinct strings
+// the records refer to, stored as UTF-16.
+class MPDLibraryCache {
+ public:
+  // The order the tree shows the songs of a library in. Taken in the GUI
+  // thread, which reorders the albums of the tree, so that the cache can
+  // be written in another one meanwhile.
+  struct Order {
+    QVector<quint32> songs;
+    MusicLibraryBuilder::AlbumOrder albums;
+  };
+
+  explicit MPDLibraryCache(const QString &host);
+
+  static Order order(const MusicLibraryItemRoot *root);
+  // Replaces the cache with the library below root, in the given order,
+  // atomically
+  bool write(const MusicLibraryItemRoot *root, const Order &order,
+             const QDateTime &dbUpdate) const;
+  // nullptr if there is no usable cache, otherwise the library & in
+  // dbUpdate the database update it was written for
+  MusicLibraryItemRoot *read(QDateTime *dbUpdate) const;
+  QString fileName() const { return fileName_; }
+
+ private:
+  QString fileName_;
+};
+
+Q_DECLARE_METATYPE(MPDLibraryCache::Order)
+
+#endif  // MPDLIBRARYCACHE_H
@@ -14,7 +14,7 @@ MusicLibraryItemAlbum::MusicLibraryItemAlbum(const QString &data,
     : MusicLibraryItem(data, MusicLibraryItem::Type::TypeAlbum),
       m_parentItem(static_cast<MusicLibraryItemArtist *>(parent)) {}
 
-MusicLibraryItemAlbum::~MusicLibraryItemAlbum() { qDeleteAll(m_childItems); }
+MusicLibraryItemAlbum::~MusicLibraryItemAlbum() {}
 
 void MusicLibraryItemAlbum::appendChild(MusicLibraryItem *const item) {
   m_childItems.append(static_cast<MusicLibraryItemSong *>(item));
@@ -38,14 +38,12 @@ int MusicLibraryItemAlbum::row() const {
       const_cast<MusicLibraryItemAlbum *>(this));
 }
 
-void MusicLibraryItemAlbum::clearChildren() { qDeleteAll(m_childItems); }
-
 MusicLibraryItemArtist::MusicLibraryItemArtist(const QString &data,
                                                MusicLibraryItem *parent)
     : MusicLibraryItem(data, MusicLibraryItem::Type::TypeArtist),
       m_parentItem(static_cast<MusicLibraryItemRoot *>(parent)) {}
 
-MusicLibraryItemArtist::~MusicLibraryItemArtist() { qDeleteAll(m_childItems); }
+MusicLibraryItemArtist::~MusicLibraryItemArtist() {}
 
 void MusicLibraryItemArtist::appendChild(MusicLibraryItem *const item) {
   m_childItems.append(static_cast<MusicLibraryItemAlbum *>(item));
@@ -66,21 +64,16 @@ MusicLibraryItem *MusicLibraryItemArtist::parent() const {
   return m_parentItem;
 }
 
-void MusicLibraryItemArtist::setParent(MusicLibraryItem *const parent) {
-  m_parentItem = static_cast<MusicLibraryItemRoot *>(parent);
-}
-
 int MusicLibraryItemArtist::row() const {
   return m_parentItem->m_childItems.indexOf(
       const_cast<MusicLibraryItemArtist *>(this));
 }
 
-void MusicLibraryItemArtist::clearChildren() { qDeleteAll(m_childItems); }
-
 MusicLibraryItemRoot::MusicLibraryItemRoot(const QString &data)
-    : MusicLibraryItem(data, MusicLibraryItem::Type::TypeRoot) {}
+    : MusicLibraryItem(data, MusicLibraryItem::Type::TypeRoot),
+      m_searchIndex(&m_songs) {}
 
-MusicLibraryItemRoot::~MusicLibraryItemRoot() { qDeleteAll(m_childItems); }
+MusicLibraryItemRoot::~MusicLibraryItemRoot() {}
 
 void MusicLibraryItemRoot::appendChild(MusicLibraryItem *const item) {
   m_childItems.append(static_cast<MusicLibraryItemArtist *>(item));
@@ -97,17 +90,20 @@ MusicLibraryItem *MusicLibraryItemRoot::child(int row) const {
 
 int MusicLibraryItemRoot::childCount() const { return m_childItems.count(); }
 
-void MusicLibraryItemRoot::clearChildren() { qDeleteAll(m_childItems); }
-
-MusicLibraryItemSong::MusicLibraryItemSong(const QString &data,
+MusicLibraryItemSong::MusicLibraryItemSong(const MPDSongTable *songs,
+                                           const quint32 song,
                                            MusicLibraryItem *parent)
-    : MusicLibraryItem(data, MusicLibraryItem::Type::TypeSong),
-      m_track(0),
-      m_disc(0),
+    : MusicLibraryItem(QString(), MusicLibraryItem::Type::TypeSong),
+      m_songs(songs),
+      m_song(song),
       m_parentItem(static_cast<MusicLibraryItemAlbum *>(parent)) {}
 
 MusicLibraryItemSong::~MusicLibraryItemSong() {}
 
+QVariant MusicLibraryItemSong::data(int /*column*/) const {
+  return m_songs->title(m_song);
+}
+
 MusicLibraryItem *MusicLibraryItemSong::parent() const { return m_parentItem; }
 
 int MusicLibraryItemSong::row() const {
@@ -115,16 +111,10 @@ int MusicLibraryItemSong::row() const {
       const_cast<MusicLibraryItemSong *>(this));
 }
 
-const QString &MusicLibraryItemSong::file() const { return m_file; }
-
-void MusicLibraryItemSong::setFile(const QString &filename) {
-  m_file = filename;
+const QString &MusicLibraryItemSong::file() const {
+  return m_songs->file(m_song);
 }
 
-void MusicLibraryItemSong::setTrack(quint32 track_nr) { m_track = track_nr; }
-
-void MusicLibraryItemSong::setDisc(quint32 disc_nr) { m_disc = disc_nr; }
-
-quint32 MusicLibraryItemSong::track() const { return m_track; }
+quint32 MusicLibraryItemSong::track() const { return m_songs->track(m_song); }
 
-quint32 MusicLibraryItemSong::disc() const { return m_disc; }
+quint32 MusicLibraryItemSong::disc() const { return m_songs->disc(m_song); }
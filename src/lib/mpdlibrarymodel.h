@@ -2,7 +2,13 @@
 #define MPDLIBRARYMODEL_H
 
 #include <QList>
+#include <QMetaType>
 #include <QVariant>
+#include <memory>
+
+#include "mpdarena.h"
+#include "mpdsearchindex.h"
+#include "mpdsongtable.h"
 
 class MusicLibraryItem {
  public:
@@ -13,7 +19,7 @@ class MusicLibraryItem {
   virtual MusicLibraryItem *child(int /*row*/) const { return nullptr; }
   virtual int childCount() const { return 0; }
   int columnCount() const { return 1; }
-  QVariant data(int column) const;
+  virtual QVariant data(int column) const;
   virtual int row() const { return 0; }
   virtual MusicLibraryItem *parent() const { return nullptr; }
   MusicLibraryItem::Type type() const;
@@ -41,13 +47,13 @@ class MusicLibraryItemAlbum : public MusicLibraryItem {
   int childCount() const;
   int row() const;
   MusicLibraryItem *parent() const;
-  void clearChildren();
 
  private:
   QList<MusicLibraryItemSong *> m_childItems;
   MusicLibraryItemArtist *const m_parentItem;
 
   friend class MusicLibraryItemSong;
+  friend class MusicLibraryBuilder;
 };
 
 class MusicLibraryItemArtist : public MusicLibraryItem {
@@ -63,14 +69,13 @@ class MusicLibraryItemArtist : public MusicLibraryItem {
   int childCount() const;
   int row() const;
   MusicLibraryItem *parent() const;
-  void setParent(MusicLibraryItem *const parent);
-  void clearChildren();
 
  private:
   QList<MusicLibraryItemAlbum *> m_childItems;
-  MusicLibraryItemRoot *m_parentItem;
+  MusicLibraryItemRoot *const m_parentItem;
 
   friend class MusicLibraryItemAlbum;
+  friend class MusicLibraryBuilder;
 };
 
 class MusicLibraryItemRoot : public MusicLibraryItem {
@@ -83,33 +88,50 @@ class MusicLibraryItemRoot : public MusicLibraryItem {
 
   MusicLibraryItem *child(int row) const;
   int childCount() const;
-  void clearChildren();
+  // the songs the song items of this library refer to
+  MPDSongTable *songs() { return &m_songs; }
+  const MPDSongTable *songs() const { return &m_songs; }
+  // artists, albums & songs are allocated here & released with the root
+  MPDArena *arena() { return &m_arena; }
+  // over the song table, brought up to date before searching
+  MPDSearchIndex *searchIndex() { return &m_searchIndex; }
+  const MPDSearchIndex *searchIndex() const { return &m_searchIndex; }
 
  private:
   QList<MusicLibraryItemArtist *> m_childItems;
+  MPDSongTable m_songs;
+  MPDSearchIndex m_searchIndex;
+  MPDArena m_arena;
 
   friend class MusicLibraryItemArtist;
+  friend class MusicLibraryBuilder;
 };
 
+// A row of the song table of the library
 class MusicLibraryItemSong : public MusicLibraryItem {
  public:
-  MusicLibraryItemSong(const QString &data, MusicLibraryItem *parent = nullptr);
+  MusicLibraryItemSong(const MPDSongTable *songs, const quint32 song,
+                       MusicLibraryItem *parent = nullptr);
   ~MusicLibraryItemSong();
 
+  QVariant data(int column) const;
   int row() const;
   MusicLibraryItem *parent() const;
+  quint32 song() const { return m_song; }
   const QString &file() const;
-  void setFile(const QString &filename);
-  void setTrack(quint32 track_nr);
-  void setDisc(quint32 disc_nr);
   quint32 track() const;
   quint32 disc() const;
 
  private:
-  quint32 m_track;
-  QString m_file;
-  quint32 m_disc;
+  const MPDSongTable *const m_songs;
+  const quint32 m_song;
   MusicLibraryItemAlbum *const m_parentItem;
 };
 
+// A library handed on once complete. Its songs aren't modified from then on,
+// only the order of its albums may change in the GUI thread.
+typedef std::shared_ptr<const MusicLibraryItemRoot> MPDLibrarySnapshot;
+
+Q_DECLARE_METATYPE(MPDLibrarySnapshot)
+
 #endif  // MPDLIBRARYMODEL_H
@@ -0,0 +1,108 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mpdlibrarysearcher.h"
+#include "mpdlibrarymodel.h"
+
+// enough to fill the view before the rest follows
+const int MPDLibrarySearcher::batchSize_ = 100;
+
+MPDLibrarySearcher::MPDLibrarySearcher(QObject *parent)
+    : QObject(parent), searchId_(0) {
+  qRegisterMetaType<QList<MPDSearchResult>>();
+  qRegisterMetaType<MPDLibrarySnapshot>();
+}
+
+quint32 MPDLibrarySearcher::search(const QString &query) {
+  const quint32 searchId = ++searchId_;
+  QMetaObject::invokeMethod(this, "run", Qt::QueuedConnection,
+                            Q_ARG(quint32, searchId), Q_ARG(QString, query));
+  return searchId;
+}
+
+void MPDLibrarySearcher::setLibrary(const MPDLibrarySnapshot &library) {
+  library_ = library;
+  lastQuery_.clear();
+  lastMatches_.clear();
+}
+
+void MPDLibrarySearcher::run(const quint32 searchId, const QString &query) {
+  // superseded while it was queued
+  if (isCancelled(searchId)) return;
+
+  if (!library_ || query.isEmpty()) {
+    emit resultsFound(searchId, QList<MPDSearchResult>(), true);
+    return;
+  }
+
+  // The matches of a query typed further are among the last ones. A single
+  // character didn't look at titles & file names, see MPDSearchIndex.
+  const MPDSearchIndex *const index = library_->searchIndex();
+  QVector<quint32> matches;
+  if (lastQuery_.size() > 1 &&
+      query.contains(lastQuery_, Qt::CaseInsensitive)) {
+    matches = index->search(query, lastMatches_);
+  } else {
+    matches = index->search(query);
+  }
+  lastQuery_ = query;
+  lastMatches_ = matches;
+  if (isCancelled(searchId)) return;
+
+  // ranked title prefix, title, tags & then path matches, in library order
+  // within a rank
+  const MPDSongTable *const songs = library_->songs();
+  QVector<quint32> ranked[4];
+  for (const quint32 song : matches) {
+    const QString &title = songs->title(song);
+    if (title.startsWith(query, Qt::CaseInsensitive)) {
+      ranked[0].append(song);
+    } else if (title.contains(query, Qt::CaseInsensitive)) {
+      ranked[1].append(song);
+    } else if (songs->tag(MPDSongTable::Tag::Artist, song)
+                   .contains(query, Qt::CaseInsensitive) ||
+               songs->tag(MPDSongTable::Tag::Album, song)
+                   .contains(query, Qt::CaseInsensitive) ||
+               songs->tag(MPDSongTable::Tag::AlbumArtist, song)
+                   .contains(query, Qt::CaseInsensitive) ||
+               songs->tag(MPDSongTable::Tag::Composer, song)
+                   .contains(query, Qt::CaseInsensitive)) {
+      ranked[2].append(song);
+    } else {
+      ranked[3].append(song);
+    }
+  }
+
+  QList<MPDSearchResult> results;
+  int remaining = matches.size();
+  for (const QVector<quint32> &rank : ranked) {
+    for (const quint32 song : rank) {
+      MPDSearchResult result;
+      result.title = songs->title(song);
+      result.artist = songs->tag(MPDSongTable::Tag::Artist, song);
+      result.album = songs->tag(MPDSongTable::Tag::Album, song);
+      result.file = songs->file(song);
+      results.append(result);
+      remaining--;
+      if (results.size() < batchSize_ && remaining > 0) continue;
+
+      if (isCancelled(searchId)) return;
+      emit resultsFound(searchId, results, remaining == 0);
+      results.clear();
+    }
+  }
+  if (matches.isEmpty()) emit resultsFound(searchId, results, true);
+}
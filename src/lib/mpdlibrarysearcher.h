@@ -0,0 +1,72 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MPDLIBRARYSEARCHER_H
+#define MPDLIBRARYSEARCHER_H
+
+#include <QList>
+#include <QMetaType>
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <memory>
+
+#include "mpdlibrarymodel.h"
+
+struct MPDSearchResult {
+  QString title;
+  QString artist;
+  QString album;
+  QString file;
+};
+
+// Searches the library in a thread of its own. Every search cancels the
+// one before, its results are handed on in batches, best matches first.
+class MPDLibrarySearcher : public QObject {
+  Q_OBJECT
+ public:
+  explicit MPDLibrarySearcher(QObject *parent = nullptr);
+
+  // May be called from any thread, returns the id the results will carry
+  quint32 search(const QString &query);
+
+ public slots:
+  // the library has to stay unmodified & its search index up to date
+  void setLibrary(const MPDLibrarySnapshot &library);
+
+ signals:
+  // last is true for the final batch of the search
+  void resultsFound(quint32 searchId, const QList<MPDSearchResult> &results,
+                    bool last);
+
+ private:
+  Q_INVOKABLE void run(const quint32 searchId, const QString &query);
+  bool isCancelled(const quint32 searchId) const {
+    return searchId != searchId_;
+  }
+
+  std::atomic<quint32> searchId_;
+  MPDLibrarySnapshot library_;
+  // the last search, narrowed down when a query extends it
+  QString lastQuery_;
+  QVector<quint32> lastMatches_;
+  static const int batchSize_;
+};
+
+Q_DECLARE_METATYPE(MPDSearchResult)
+
+#endif  // MPDLIBRARYSEARCHER_H
@@ -1,7 +1,10 @@
 #ifndef MPDMODEL_H
 #define MPDMODEL_H
 
+#include <QList>
+#include <QMetaType>
 #include <QObject>
+#include <memory>
 
 enum class MPDPlaybackState {
   Inactive,
@@ -62,7 +65,8 @@ struct MPDStatsValues {
         songs(0),
         uptime(0),
         playtime(0),
-        dbPlaytime(0) {}
+        dbPlaytime(0),
+        dbUpdate(0) {}
   quint32 artists;
   quint32 albums;
   quint32 songs;
@@ -97,4 +101,28 @@ struct MPDSongMetadata {
   uint pos;
 };
 
+// How the queue changed since the version last seen, as plchanges reports
+// it: the songs now at the positions that changed, by ascending position, &
+// the new length. Songs already in the queue may only carry pos & id
+// (plchangesposid), the rest of the queue stays as it was.
+struct MPDQueueChanges {
+  MPDQueueChanges() : length(0) {}
+  quint32 length;
+  QList<MPDSongMetadata> songs;
+};
+
+// Parsed in the MPD thread & handed to the GUI, never modified afterwards.
+typedef std::shared_ptr<const MPDStatusValues> MPDStatusSnapshot;
+typedef std::shared_ptr<const MPDStatsValues> MPDStatsSnapshot;
+typedef std::shared_ptr<const MPDSongMetadata> MPDSongSnapshot;
+typedef std::shared_ptr<const QList<MPDSongMetadata>> MPDPlaylistSnapshot;
+typedef std::shared_ptr<const MPDQueueChanges> MPDQueueChangesSnapshot;
+
+Q_DECLARE_METATYPE(MPDSongMetadata)
+Q_DECLARE_METATYPE(MPDStatusSnapshot)
+Q_DECLARE_METATYPE(MPDStatsSnapshot)
+Q_DECLARE_METATYPE(MPDSongSnapshot)
+Q_DECLARE_METATYPE(MPDPlaylistSnapshot)
+Q_DECLARE_METATYPE(MPDQueueChangesSnapshot)
+
 #endif  // MPDMODEL_H
@@ -0,0 +1,37 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "mpdqueuerange.h"
+
+#include <algorithm>
+
+QList<MPDQueueRange::Range> MPDQueueRange::ranges(QList<qint32> positions,
+                                                  const qint32 split) {
+  std::sort(positions.begin(), positions.end());
+  QList<Range> positionRanges;
+  for (const qint32 position : positions) {
+    if (!positionRanges.isEmpty() &&
+        positionRanges.last().second == position && position != split) {
+      positionRanges.last().second++;
+    } else if (positionRanges.isEmpty() ||
+               positionRanges.last().second <= position) {
+      // duplicates are skipped
+      positionRanges.append(Range(position, position + 1));
+    }
+  }
+  return positionRanges;
+}
@@ -0,0 +1,34 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef MPDQUEUERANGE_H
+#define MPDQUEUERANGE_H
+
+#include <QList>
+#include <QPair>
+
+namespace MPDQueueRange {
+// [start, end) of consecutive positions in the queue, one command edits
+// all of them
+typedef QPair<qint32, qint32> Range;
+
+// The ranges of the positions in ascending order, duplicates skipped. A
+// range is also split at position split.
+QList<Range> ranges(QList<qint32> positions, qint32 split = -1);
+}  // namespace MPDQueueRange
+
+#endif  // MPDQUEUERANGE_H
@@ -0,0 +1,227 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mpdsearchindex.h"
+#include "mpdsongtable.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+// three UTF-16 code units starting at chars
+inline quint64 trigramAt(const QChar *chars) {
+  return (quint64(chars[0].unicode()) << 32) |
+         (quint64(chars[1].unicode()) << 16) | chars[2].unicode();
+}
+
+// the file name of a path, without copying it
+inline QStringRef fileNameOf(const QString &file) {
+  return file.midRef(file.lastIndexOf('/') + 1);
+}
+}  // namespace
+
+MPDSearchIndex::MPDSearchIndex(const MPDSongTable *songs)
+    : songs_(songs), indexedSongs_(0), indexedValues_(0) {
+  // songs in the root of the music directory
+  dirs_.append(QString());
+  dirIds_.insert(QString(), 0);
+}
+
+void MPDSearchIndex::update() {
+  // may be shared with searches in other threads once complete
+  if (indexedSongs_ == songs_->size() &&
+      indexedValues_ == songs_->valueCount()) {
+    return;
+  }
+
+  for (int i = indexedValues_; i < songs_->valueCount(); i++) {
+    const quint32 value = static_cast<quint32>(i);
+    addTrigrams(songs_->value(value), value, &valueTrigrams_);
+  }
+  indexedValues_ = songs_->valueCount();
+
+  songDirs_.reserve(songs_->size());
+  for (int i = indexedSongs_; i < songs_->size(); i++) {
+    const quint32 song = static_cast<quint32>(i);
+    const QString &file = songs_->file(song);
+    const int slash = file.lastIndexOf('/');
+    const QString dir = file.left(qMax(slash, 0));
+
+    QHash<QString, quint32>::const_iterator it = dirIds_.constFind(dir);
+    if (it == dirIds_.constEnd()) {
+      const quint32 id = static_cast<quint32>(dirs_.size());
+      dirs_.append(dir);
+      it = dirIds_.insert(dir, id);
+      addTrigrams(dir, id, &dirTrigrams_);
+    }
+    songDirs_.append(it.value());
+
+    addTrigrams(songs_->title(song), song, &songTrigrams_);
+    addTrigrams(file.mid(slash + 1), song, &songTrigrams_);
+  }
+  indexedSongs_ = songs_->size();
+}
+
+QVector<quint32> MPDSearchIndex::search(const QString &query) const {
+  QVector<quint32> matches;
+  const QString folded = query.toCaseFolded();
+  if (folded.isEmpty()) return matches;
+
+  const auto contains = [&folded](const QString &text) {
+    return text.contains(folded, Qt::CaseInsensitive);
+  };
+  const auto songContains = [this, &folded](const quint32 song) {
+    return songs_->title(song).contains(folded, Qt::CaseInsensitive) ||
+           fileNameOf(songs_->file(song)).contains(folded,
+                                                   Qt::CaseInsensitive);
+  };
+
+  // which distinct values, directories & songs contain the query, trigrams
+  // only narrow them down. Shorter queries are looked up among the
+  // trigrams they start or end, or for a single character among the
+  // distinct values & directories only.
+  QVector<bool> values(indexedValues_, false);
+  QVector<bool> dirs(dirs_.size(), false);
+  QVector<bool> songs(indexedSongs_, false);
+  if (folded.size() == 1) {
+    for (int i = 0; i < indexedValues_; i++) {
+      values[i] = contains(songs_->value(static_cast<quint32>(i)));
+    }
+    for (int i = 0; i < dirs_.size(); i++) dirs[i] = contains(dirs_.at(i));
+  } else if (folded.size() == 2) {
+    markBigram(folded, valueTrigrams_, &values);
+    markBigram(folded, dirTrigrams_, &dirs);
+    markBigram(folded, songTrigrams_, &songs);
+  } else {
+    for (const quint32 value : candidates(folded, valueTrigrams_)) {
+      values[static_cast<int>(value)] = contains(songs_->value(value));
+    }
+    for (const quint32 dir : candidates(folded, dirTrigrams_)) {
+      dirs[static_cast<int>(dir)] = contains(dirs_.at(static_cast<int>(dir)));
+    }
+    for (const quint32 song : candidates(folded, songTrigrams_)) {
+      songs[static_cast<int>(song)] = songContains(song);
+    }
+  }
+
+  // a single pass over the tag columns maps the values to their songs
+  const quint32 *const artist =
+      songs_->column(MPDSongTable::Tag::Artist).constData();
+  const quint32 *const album =
+      songs_->column(MPDSongTable::Tag::Album).constData();
+  const quint32 *const albumArtist =
+      songs_->column(MPDSongTable::Tag::AlbumArtist).constData();
+  const quint32 *const composer =
+      songs_->column(MPDSongTable::Tag::Composer).constData();
+  const quint32 *const songDir = songDirs_.constData();
+  for (int i = 0; i < indexedSongs_; i++) {
+    if (songs.at(i) || dirs.at(songDir[i]) || values.at(artist[i]) ||
+        values.at(album[i]) || values.at(albumArtist[i]) ||
+        values.at(composer[i])) {
+      matches.append(static_cast<quint32>(i));
+    }
+  }
+  return matches;
+}
+
+QVector<quint32> MPDSearchIndex::search(const QString &query,
+                                        const QVector<quint32> &songs) const {
+  QVector<quint32> matching;
+  const QString folded = query.toCaseFolded();
+  if (folded.isEmpty()) return matching;
+
+  for (const quint32 song : songs) {
+    if (matches(song, folded)) matching.append(song);
+  }
+  return matching;
+}
+
+bool MPDSearchIndex::matches(const quint32 song,
+                             const QString &folded) const {
+  const auto contains = [&folded](const QString &text) {
+    return text.contains(folded, Qt::CaseInsensitive);
+  };
+  const QString &file = songs_->file(song);
+  const QString &dir =
+      dirs_.at(static_cast<int>(songDirs_.at(static_cast<int>(song))));
+  return contains(songs_->title(song)) ||
+         contains(songs_->tag(MPDSongTable::Tag::Artist, song)) ||
+         contains(songs_->tag(MPDSongTable::Tag::Album, song)) ||
+         contains(songs_->tag(MPDSongTable::Tag::AlbumArtist, song)) ||
+         contains(songs_->tag(MPDSongTable::Tag::Composer, song)) ||
+         contains(dir) ||
+         fileNameOf(file).contains(folded, Qt::CaseInsensitive);
+}
+
+void MPDSearchIndex::addTrigrams(const QString &text, const quint32 id,
+                                 Postings *postings) {
+  QString folded = text.toCaseFolded();
+  // shorter texts are padded to one trigram, for markBigram() to find
+  if (!folded.isEmpty() && folded.size() < 3) {
+    folded.append(QString(3 - folded.size(), QChar()));
+  }
+  const QChar *const chars = folded.constData();
+  for (int i = 0; i + 2 < folded.size(); i++) {
+    // ids are added in ascending order, so a repeat is the last one
+    QVector<quint32> &ids = (*postings)[trigramAt(chars + i)];
+    if (ids.isEmpty() || ids.last() != id) ids.append(id);
+  }
+}
+
+void MPDSearchIndex::markBigram(const QString &bigram,
+                                const Postings &postings,
+                                QVector<bool> *ids) {
+  // A text contains the bigram if one of its trigrams starts or ends with
+  // it. The distinct trigrams are far fewer than the texts, & only the
+  // lists of those that match are walked.
+  const quint64 wanted =
+      (quint64(bigram.at(0).unicode()) << 16) | bigram.at(1).unicode();
+  bool *const marks = ids->data();
+  for (Postings::const_iterator it = postings.constBegin();
+       it != postings.constEnd(); ++it) {
+    if ((it.key() >> 16) != wanted && (it.key() & 0xffffffff) != wanted) {
+      continue;
+    }
+    for (const quint32 id : it.value()) marks[id] = true;
+  }
+}
+
+QVector<quint32> MPDSearchIndex::candidates(const QString &query,
+                                            const Postings &postings) {
+  const QChar *const chars = query.constData();
+  QVector<const QVector<quint32> *> lists;
+  for (int i = 0; i + 2 < query.size(); i++) {
+    const Postings::const_iterator it =
+        postings.constFind(trigramAt(chars + i));
+    if (it == postings.constEnd()) return QVector<quint32>();
+    lists.append(&it.value());
+  }
+
+  // intersecting from the rarest trigram on keeps the lists short
+  std::sort(lists.begin(), lists.end(),
+            [](const QVector<quint32> *a, const QVector<quint32> *b) {
+              return a->size() < b->size();
+            });
+  QVector<quint32> ids = *lists.first();
+  for (int i = 1; i < lists.size() && !ids.isEmpty(); i++) {
+    QVector<quint32> common;
+    std::set_intersection(ids.constBegin(), ids.constEnd(),
+                          lists.at(i)->constBegin(), lists.at(i)->constEnd(),
+                          std::back_inserter(common));
+    ids.swap(common);
+  }
+  return ids;
+}
@@ -0,0 +1,77 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MPDSEARCHINDEX_H
+#define MPDSEARCHINDEX_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+class MPDSongTable;
+
+// Inverted trigram index over the title, artist, album, album artist,
+// composer & file path of the songs of a song table, for substring search.
+// Tag values & directories repeat across songs, so each distinct one is
+// indexed once & mapped to its songs through the table's columns. Titles &
+// file names are indexed per song. A single character is only looked for
+// in the tag values & directories, titles & file names nearly all have it.
+class MPDSearchIndex {
+ public:
+  explicit MPDSearchIndex(const MPDSongTable *songs);
+
+  // Indexes the songs appended to the table since the last update
+  void update();
+  // Ids of the indexed songs that contain query in one of the fields,
+  // ignoring case, ascending. A match in the file path can't span its
+  // directory & file name.
+  QVector<quint32> search(const QString &query) const;
+  // Like search() but only among songs, ascending ids of indexed songs.
+  // The matches of a query extended from an earlier one of at least two
+  // characters are among its.
+  QVector<quint32> search(const QString &query,
+                          const QVector<quint32> &songs) const;
+
+ private:
+  // trigrams are three UTF-16 code units
+  typedef QHash<quint64, QVector<quint32>> Postings;
+
+  bool matches(const quint32 song, const QString &folded) const;
+  static void addTrigrams(const QString &text, const quint32 id,
+                          Postings *postings);
+  // ids that have every trigram of query, ascending
+  static QVector<quint32> candidates(const QString &query,
+                                     const Postings &postings);
+  // marks the ids that contain the two code units of bigram
+  static void markBigram(const QString &bigram, const Postings &postings,
+                         QVector<bool> *ids);
+
+  const MPDSongTable *const songs_;
+  int indexedSongs_;
+  int indexedValues_;
+  // title & file name -> song ids
+  Postings songTrigrams_;
+  // distinct tag values -> value ids of the table
+  Postings valueTrigrams_;
+  // distinct directories -> directory ids
+  Postings dirTrigrams_;
+  QVector<QString> dirs_;
+  QHash<QString, quint32> dirIds_;
+  // directory id per song id
+  QVector<quint32> songDirs_;
+};
+
+#endif  // MPDSEARCHINDEX_H
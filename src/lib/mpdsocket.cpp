@@ -16,157 +16,436 @@
 
 #include "mpdsocket.h"
 
+#include <QDebug>
+#include <QThread>
+
+#include <cstring>
+
 static const QByteArray okResponse("OK");
 static const QByteArray okmpdResponse("OK MPD");
-static const QByteArray oknResponse("OK\n");
 static const QByteArray ackResponse("ACK");
 static const QByteArray messageResponse("message");
 
 const int MPDSocket::socketReadTimeOut_ = 5000;
 const int MPDSocket::socketMaxReadAttempt_ = 9;
+const int MPDSocket::readBufferSize_ = 64 * 1024;
+const int MPDSocket::maxReadBufferCapacity_ = 1024 * 1024;
+
+// A reply ends with a line that is either "OK", the "OK MPD <version>"
+// greeting or an "ACK [error@command_listNum] {command} message" error.
+static inline bool isOkLine(const char *line, const int length) {
+  return length >= okResponse.size() &&
+         qstrncmp(line, okResponse.constData(), okResponse.size()) == 0 &&
+         (length == okResponse.size() || line[okResponse.size()] == ' ');
+}
+
+static inline bool isAckLine(const char *line, const int length) {
+  return length > ackResponse.size() &&
+         qstrncmp(line, ackResponse.constData(), ackResponse.size()) == 0 &&
+         line[ackResponse.size()] == ' ';
+}
 
 MPDSocket::MPDSocket(QObject *parent)
-    : QTcpSocket(parent),
+    : QObject(parent),
+      tcpSocket_(new QTcpSocket(this)),
+      localSocket_(new QLocalSocket(this)),
+      device_(tcpSocket_),
+      keepAlive_(false),
       hostname_(""),
       port_(0),
       passwd_(""),
-      mpdCmdReply_(QByteArray(), false) {
-  connect(this,
+      replyStart_(0),
+      scanPos_(0),
+      bufferEpoch_(0),
+      responseTimer_(this),
+      responseTimeoutEnabled_(true),
+      latency_(-1),
+      healthy_(false) {
+  readBuffer_.reserve(readBufferSize_);
+  clock_.start();
+  responseTimer_.setSingleShot(true);
+  responseTimer_.setInterval(socketReadTimeOut_ * socketMaxReadAttempt_);
+  connect(tcpSocket_,
           static_cast<void (QTcpSocket::*)(const QAbstractSocket::SocketError)>(
               &QTcpSocket::error),
           this, &MPDSocket::onError);
+  connect(localSocket_,
+          static_cast<void (QLocalSocket::*)(
+              const QLocalSocket::LocalSocketError)>(&QLocalSocket::error),
+          this, &MPDSocket::onLocalError);
+  // only the transport in use ever emits these
+  connect(tcpSocket_, &QTcpSocket::readyRead, this, &MPDSocket::onReadyRead);
+  connect(localSocket_, &QLocalSocket::readyRead, this,
+          &MPDSocket::onReadyRead);
+  connect(tcpSocket_, &QTcpSocket::disconnected, this,
+          &MPDSocket::failPendingCommands);
+  connect(localSocket_, &QLocalSocket::disconnected, this,
+          &MPDSocket::failPendingCommands);
+  connect(&responseTimer_, &QTimer::timeout, this,
+          &MPDSocket::onResponseTimeout);
 }
 
 void MPDSocket::connectToMPDHost(const QString &hostName, const quint16 port,
                                  const QString &password,
                                  const QIODevice::OpenMode mode) {
-  if (!isConnected()) {
-    QByteArray data;
+  if (isConnected()) {
+    qCritical() << "Couldn't connect - already connected";
+    return;
+  }
 
-    if (hostName != hostname_) hostname_ = hostName;
-    if (port != port_) port_ = port;
-    if (password != passwd_) passwd_ = password;
+  if (hostName != hostname_) hostname_ = hostName;
+  if (port != port_) port_ = port;
+  if (password != passwd_) passwd_ = password;
 
-    if (hostname_.isEmpty() || port_ == 0) {
-      qCritical() << "no valid hostname and/or port";
-      qInfo() << hostname_ << port_;
-      return;
-    }
+  // an absolute path is MPD's unix domain socket, which has no port
+  const bool local = hostname_.startsWith('/');
+  if (hostname_.isEmpty() || (!local && port_ == 0)) {
+    qCritical() << "no valid hostname and/or port";
+    qInfo() << hostname_ << port_;
+    return;
+  }
 
-    connectToHost(hostname_, port_, mode);
+  resetReadBuffer();
+  bool connected = false;
+  if (local) {
+    device_ = localSocket_;
+    localSocket_->connectToServer(hostname_, mode);
+    connected = localSocket_->waitForConnected(socketReadTimeOut_);
+  } else {
+    device_ = tcpSocket_;
+    tcpSocket_->connectToHost(hostname_, port_, mode);
+    connected = tcpSocket_->waitForConnected(socketReadTimeOut_);
+    if (connected && keepAlive_) {
+      tcpSocket_->setSocketOption(QAbstractSocket::KeepAliveOption, 1);
+    }
+  }
 
-    if (waitForConnected(socketReadTimeOut_)) {
-      qInfo() << "MPD Connection established";
-      data = readFromMPDSocket();
+  if (!connected) {
+    qInfo() << "Couldn't connect";
+    return;
+  }
 
-      if (data.isEmpty()) {
-        qInfo() << "Couldn't connect";
-        return;
-      }
+  qInfo() << "MPD Connection established";
 
-      if (data.startsWith(okmpdResponse)) {
-        qInfo() << "MPD connected";
-      }
+  // MPD greets every new connection, so the greeting is handled like the
+  // reply of a command that has already been sent.
+  enqueueCommand(QByteArray(), MPDChunkHandler(),
+                 [](const QPair<QByteArray, bool> &greeting) {
+                   if (greeting.first.startsWith(okmpdResponse)) {
+                     qInfo() << "MPD connected";
+                   }
+                 });
 
-      data.clear();
+  if (!passwd_.isEmpty()) {
+    qInfo() << "setting password...";
+    sendCommand("password " + passwd_.toUtf8(),
+                [this](const QPair<QByteArray, bool> &reply) {
+                  if (!reply.second) {
+                    qCritical() << "password rejected";
+                    close();
+                  }
+                });
+  }
 
-      if (!passwd_.isEmpty()) {
-        qInfo() << "setting password...";
-        write("password " + passwd_.toUtf8() + '\n');
-        waitForBytesWritten(socketReadTimeOut_);
-        if (!readFromMPDSocket().endsWith(oknResponse)) {
-          qCritical() << "password rejected";
-          close();
-          return;
-        }
-      }
-    }
-  } else {
-    qCritical() << "Couldn't connect - " << errorString() << error();
+  // Connection setup is the only place we block, the caller needs to know
+  // whether the handshake succeeded before going on.
+  if (!waitForPendingCommands()) {
+    qInfo() << "Couldn't connect";
+    return;
   }
+  setHealthy(true);
 }
 
 void MPDSocket::disconnectFromMPDHost() {
   qInfo() << "Disconnect from MPD";
   if (isConnected()) {
-    disconnectFromHost();
+    if (device_ == localSocket_) {
+      localSocket_->disconnectFromServer();
+    } else {
+      tcpSocket_->disconnectFromHost();
+    }
   }
   close();
+  failPendingCommands();
 }
 
-QByteArray MPDSocket::readFromMPDSocket() {
-  QByteArray data;
-  int attempt = 0;
-  while (isConnected()) {
-    while (bytesAvailable() == 0 && isConnected()) {
-      qDebug() << this << " Waiting for read data, attempt " << attempt;
-      if (waitForReadyRead(socketReadTimeOut_)) {
-        break;
-      }
-      qDebug() << "Wait for read failed - " << errorString();
-      attempt++;
-      if (attempt >= socketMaxReadAttempt_) {
-        qCritical() << "ERROR: Timedout waiting for response";
-        close();
-        return QByteArray();
-      }
-    }
+bool MPDSocket::isConnected() const {
+  if (device_ == localSocket_) {
+    return (localSocket_->state() == QLocalSocket::ConnectedState);
+  }
+  return (tcpSocket_->state() == QAbstractSocket::ConnectedState);
+}
 
-    data.append(readAll());
+void MPDSocket::close() { device_->close(); }
 
-    if (data.endsWith(oknResponse) || data.startsWith(okResponse) ||
-        data.startsWith(ackResponse)) {
-      break;
-    }
+void MPDSocket::setKeepAliveEnabled(const bool enabled) {
+  keepAlive_ = enabled;
+  if (device_ == tcpSocket_ && isConnected()) {
+    tcpSocket_->setSocketOption(QAbstractSocket::KeepAliveOption,
+                                keepAlive_ ? 1 : 0);
+  }
+}
+
+void MPDSocket::writeCommand(const QByteArray &command) {
+  if (thread() != QThread::currentThread()) {
+    QMetaObject::invokeMethod(this, "writeCommand", Qt::QueuedConnection,
+                              Q_ARG(QByteArray, command));
+    return;
   }
-  qDebug() << this << "Read:" << data << ", socket state: " << state();
 
-  return data;
+  qDebug() << "sending Command: " << command;
+  if (isConnected() && device_->write(command + '\n') == -1) {
+    qCritical() << "Failed to write";
+    close();
+  }
 }
 
-QPair<QByteArray, bool> MPDSocket::getMPDResponse() {
-  mpdCmdReply_.first = readFromMPDSocket();
-  mpdCmdReply_.second = mpdCmdReply_.first.endsWith(oknResponse);
-  return mpdCmdReply_;
+void MPDSocket::sendCommand(const QByteArray &command,
+                            const MPDResponseHandler &handler) {
+  sendCommand(command, MPDChunkHandler(), handler);
 }
 
-QPair<QByteArray, bool> MPDSocket::sendCommand(const QByteArray &command,
-                                               const bool emitErrors,
-                                               const bool retry) {
-  qDebug() << "sending Command: " << command << emitErrors << retry;
-  QPair<QByteArray, bool> mpdCmdResponse(QByteArray(), false);
+void MPDSocket::sendCommand(const QByteArray &command,
+                            const MPDChunkHandler &chunkHandler,
+                            const MPDResponseHandler &handler) {
+  // controllers are used from the GUI thread, queued calls keep the order
+  // in which the commands were sent
+  if (thread() != QThread::currentThread()) {
+    QMetaObject::invokeMethod(this, "sendCommand", Qt::QueuedConnection,
+                              Q_ARG(QByteArray, command),
+                              Q_ARG(MPDChunkHandler, chunkHandler),
+                              Q_ARG(MPDResponseHandler, handler));
+    return;
+  }
+
+  qDebug() << "sending Command: " << command;
   if (!isConnected()) {
     qCritical() << "Failed to send command to " << command
                 << "- not connected!";
-    return mpdCmdResponse;
+    if (handler) handler(QPair<QByteArray, bool>(QByteArray(), false));
+    return;
   }
 
-  if (write(command + '\n') == -1) {
+  if (device_->write(command + '\n') == -1) {
     qCritical() << "Failed to write";
-    // If we fail to write, dont wait for bytes to be written!!
+    if (handler) handler(QPair<QByteArray, bool>(QByteArray(), false));
+    // If we fail to write, dont wait for a reply!!
     close();
+    return;
+  }
+
+  enqueueCommand(command, chunkHandler, handler);
+}
+
+void MPDSocket::enqueueCommand(const QByteArray &command,
+                               const MPDChunkHandler &chunkHandler,
+                               const MPDResponseHandler &handler) {
+  PendingCommand pending;
+  pending.command = command;
+  pending.chunkHandler = chunkHandler;
+  pending.handler = handler;
+  pending.sentAt = clock_.elapsed();
+  pendingCommands_.enqueue(pending);
+  if (responseTimeoutEnabled_ && !responseTimer_.isActive()) {
+    responseTimer_.start();
+  }
+}
+
+void MPDSocket::setResponseTimeoutEnabled(const bool enabled) {
+  responseTimeoutEnabled_ = enabled;
+  if (!responseTimeoutEnabled_) {
+    responseTimer_.stop();
+  } else if (!pendingCommands_.isEmpty()) {
+    responseTimer_.start();
+  }
+}
+
+void MPDSocket::onReadyRead() {
+  // read straight into the buffer, it grows geometrically & is reused
+  const qint64 available = device_->bytesAvailable();
+  if (available > 0) {
+    const int size = readBuffer_.size();
+    readBuffer_.resize(size + static_cast<int>(available));
+    const qint64 received =
+        device_->read(readBuffer_.data() + size, available);
+    readBuffer_.resize(size + static_cast<int>(qMax<qint64>(received, 0)));
+  }
+
+  // only the lines received since the last call are scanned
+  const quint32 epoch = bufferEpoch_;
+  while (!pendingCommands_.isEmpty()) {
+    const char *const line = readBuffer_.constData() + scanPos_;
+    const char *const lineEnd = static_cast<const char *>(
+        memchr(line, '\n', readBuffer_.size() - scanPos_));
+    if (!lineEnd) break;
+
+    const int terminatorStart = scanPos_;
+    const int lineLength = lineEnd - line;
+    scanPos_ += lineLength + 1;
+
+    const bool ok = isOkLine(line, lineLength);
+    if (!ok && !isAckLine(line, lineLength)) continue;
+
+    const PendingCommand pending = pendingCommands_.dequeue();
+    if (pending.chunkHandler && terminatorStart > replyStart_) {
+      deliverChunk(pending.chunkHandler, terminatorStart);
+      // the chunk handler may have closed the connection as well
+      if (epoch != bufferEpoch_) {
+        if (pending.handler) {
+          pending.handler(QPair<QByteArray, bool>(QByteArray(), false));
+        }
+        return;
+      }
+    }
+    const QPair<QByteArray, bool> reply(takeReply(scanPos_), ok);
+
+    // idle replies measure the time until something happened, not latency
+    if (responseTimeoutEnabled_) {
+      const qint64 roundTrip = clock_.elapsed() - pending.sentAt;
+      latency_ = latency_ < 0 ? roundTrip : (latency_ * 7 + roundTrip) / 8;
+    }
+    if (!healthy_) setHealthy(true);
+
+    qDebug() << this << "Read:" << reply.first;
+    if (ok) {
+      qDebug() << "sentCommand: " << pending.command << " sucessful!";
+    } else {
+      qWarning() << "sent Command: " << pending.command << " failed!";
+    }
+    if (!pending.command.isEmpty()) {
+      emit commandsent(pending.command, reply.first);
+    }
+    if (pending.handler) pending.handler(reply);
+
+    // the handler may have closed the connection & dropped the buffer
+    if (epoch != bufferEpoch_) return;
+  }
+
+  // a streamed reply hands its complete lines on right away, only the
+  // partial last line stays buffered
+  if (!pendingCommands_.isEmpty() && pendingCommands_.head().chunkHandler &&
+      scanPos_ > replyStart_) {
+    const MPDChunkHandler chunkHandler = pendingCommands_.head().chunkHandler;
+    deliverChunk(chunkHandler, scanPos_);
+  }
+
+  compactReadBuffer();
+
+  if (pendingCommands_.isEmpty()) {
+    responseTimer_.stop();
+  } else if (responseTimeoutEnabled_) {
+    // data is flowing, give the pending reply the full timeout again
+    responseTimer_.start();
+  }
+}
+
+QByteArray MPDSocket::takeReply(const int end) {
+  QByteArray reply;
+  if (replyStart_ == 0 && end == readBuffer_.size()) {
+    // the reply is all that is buffered, hand the buffer itself out
+    reply.swap(readBuffer_);
+    readBuffer_.reserve(readBufferSize_);
+    replyStart_ = 0;
+    scanPos_ = 0;
+  } else {
+    reply = readBuffer_.mid(replyStart_, end - replyStart_);
+    replyStart_ = end;
+  }
+  return reply;
+}
+
+void MPDSocket::deliverChunk(const MPDChunkHandler &chunkHandler,
+                             const int end) {
+  // the chunk points into the buffer, our reference keeps it alive should
+  // the handler drop the connection
+  const QByteArray buffer(readBuffer_);
+  const int start = replyStart_;
+  replyStart_ = end;
+  chunkHandler(
+      QByteArray::fromRawData(buffer.constData() + start, end - start));
+}
+
+void MPDSocket::compactReadBuffer() {
+  if (replyStart_ == 0) return;
+
+  if (replyStart_ == readBuffer_.size() &&
+      readBuffer_.capacity() <= maxReadBufferCapacity_) {
+    // capacity is reserved, so this keeps the allocation around
+    readBuffer_.resize(0);
+  } else if (replyStart_ == readBuffer_.size()) {
+    // don't hold on to what the last huge reply needed
+    readBuffer_ = QByteArray();
+    readBuffer_.reserve(readBufferSize_);
+  } else if (replyStart_ >= readBuffer_.size() - replyStart_) {
+    // never move more than was consumed, keeps reading linear overall
+    readBuffer_.remove(0, replyStart_);
   } else {
-    const int timeout = 5000;
-    qDebug() << "Timeout (ms): " << timeout;
-    waitForBytesWritten(timeout);
-    qDebug() << "Socket state after write: " << state();
-    mpdCmdResponse = getMPDResponse();
+    return;
   }
+  scanPos_ -= replyStart_;
+  replyStart_ = 0;
+}
 
-  if (!mpdCmdResponse.second) {
-    qWarning() << "sent Command: " << command << " failed!";
-    emit commandsent(command, mpdCmdResponse.first);
+void MPDSocket::resetReadBuffer() {
+  readBuffer_ = QByteArray();
+  readBuffer_.reserve(readBufferSize_);
+  replyStart_ = 0;
+  scanPos_ = 0;
+  bufferEpoch_++;
+}
 
-    // Try one more time if retry status is true
-    if (mpdCmdResponse.first.isEmpty() && retry) {
-      return sendCommand(command, emitErrors, false);
+void MPDSocket::onResponseTimeout() {
+  qCritical() << "ERROR: Timedout waiting for response";
+  close();
+  failPendingCommands();
+}
+
+bool MPDSocket::waitForPendingCommands() {
+  int attempt = 0;
+  while (!pendingCommands_.isEmpty() && isConnected()) {
+    qDebug() << this << " Waiting for read data, attempt " << attempt;
+    if (device_->waitForReadyRead(socketReadTimeOut_)) continue;
+
+    qDebug() << "Wait for read failed - " << device_->errorString();
+    attempt++;
+    if (attempt >= socketMaxReadAttempt_) {
+      qCritical() << "ERROR: Timedout waiting for response";
+      close();
+      failPendingCommands();
+      return false;
     }
-    return mpdCmdResponse;
   }
+  return isConnected();
+}
+
+void MPDSocket::failPendingCommands() {
+  responseTimer_.stop();
+  resetReadBuffer();
+  setHealthy(false);
+
+  QQueue<PendingCommand> failed;
+  failed.swap(pendingCommands_);
+  while (!failed.isEmpty()) {
+    const PendingCommand pending = failed.dequeue();
+    qWarning() << "sent Command: " << pending.command << " failed!";
+    if (pending.handler) {
+      pending.handler(QPair<QByteArray, bool>(QByteArray(), false));
+    }
+  }
+}
+
+void MPDSocket::setHealthy(const bool healthy) {
+  if (healthy_ == healthy) return;
+  healthy_ = healthy;
+  qInfo() << "MPD connection" << objectName()
+          << (healthy_ ? "healthy" : "unhealthy");
+  emit healthChanged(healthy_);
+}
 
-  qDebug() << "sentCommand: " << command << " sucessful!";
-  emit commandsent(command, mpdCmdResponse.first);
-  return mpdCmdResponse;
+void MPDSocket::onLocalError(
+    const QLocalSocket::LocalSocketError socketError) const {
+  qCritical() << "MPD Socket Error:" << socketError
+              << localSocket_->errorString() << hostname_;
 }
 
 void MPDSocket::onError(const QAbstractSocket::SocketError socketError) const {
@@ -17,9 +17,30 @@
 #ifndef MPDSOCKET_H
 #define MPDSOCKET_H
 
+#include <QElapsedTimer>
+#include <QLocalSocket>
+#include <QQueue>
 #include <QTcpSocket>
+#include <QTimer>
+#include <functional>
 
-class MPDSocket : public QTcpSocket {
+// Invoked once the complete reply (terminated by OK or ACK) of a command has
+// been received. second is true for an OK reply.
+typedef std::function<void(const QPair<QByteArray, bool> &)>
+    MPDResponseHandler;
+// Invoked with every run of complete reply lines as soon as it arrives, the
+// MPDResponseHandler of a streamed command only gets the OK or ACK line.
+// The chunk points into the receive buffer & is only valid during the call.
+typedef std::function<void(const QByteArray &)> MPDChunkHandler;
+
+Q_DECLARE_METATYPE(MPDResponseHandler)
+Q_DECLARE_METATYPE(MPDChunkHandler)
+
+// Connection to MPD over TCP, or over its unix domain socket when the host
+// is an absolute path like /run/mpd/socket.
+// Commands may be sent from any thread, they are written from the socket's
+// own thread & their handlers are invoked there.
+class MPDSocket : public QObject {
   Q_OBJECT
  public:
   explicit MPDSocket(QObject *parent = nullptr);
@@ -27,27 +48,91 @@ class MPDSocket : public QTcpSocket {
                         const QString &password,
                         const QIODevice::OpenMode mode = QIODevice::ReadWrite);
   void disconnectFromMPDHost();
-  QByteArray readFromMPDSocket();
-  QPair<QByteArray, bool> getMPDResponse();
-  inline bool isConnected() const {
-    return (state() == QAbstractSocket::ConnectedState);
-  }
-  QPair<QByteArray, bool> sendCommand(const QByteArray &command,
-                   const bool emitErrors = true, const bool retry = false);
+  bool isConnected() const;
+  // MPD serves local file URIs only to clients on its unix domain socket
+  inline bool isLocalConnection() const { return device_ == localSocket_; }
+  inline int pendingCommandCount() const { return pendingCommands_.size(); }
+  // connected & the last reply did not time out
+  inline bool isHealthy() const { return isConnected() && healthy_; }
+  // smoothed round trip time of the last replies in ms, -1 if unknown
+  inline qint64 latency() const { return latency_; }
+  // Replies that may legitimately take forever (idle) must not time out.
+  void setResponseTimeoutEnabled(const bool enabled);
+  // TCP keepalive, applied on connect. Unix domain sockets don't need it.
+  void setKeepAliveEnabled(const bool enabled);
+
+  // Writes the command right away and queues its handler. Several commands
+  // may be in flight at once, replies are dispatched in FIFO order.
+  void sendCommand(const QByteArray &command,
+                   const MPDResponseHandler &handler = MPDResponseHandler());
+  // Streams the reply instead of buffering it, for listings that can get
+  // larger than what we want to hold in memory at once.
+  Q_INVOKABLE void sendCommand(const QByteArray &command,
+                   const MPDChunkHandler &chunkHandler,
+                   const MPDResponseHandler &handler);
+  // Writes a command that gets no reply of its own, like noidle which
+  // completes the pending idle.
+  Q_INVOKABLE void writeCommand(const QByteArray &command);
 
  public slots:
   void onError(const QAbstractSocket::SocketError socketError) const;
 
 signals:
   void commandsent(QString command, QByteArray result);
+  void healthChanged(bool healthy);
+
+ private slots:
+  void onReadyRead();
+  void onResponseTimeout();
+  void onLocalError(const QLocalSocket::LocalSocketError socketError) const;
 
  private:
+  struct PendingCommand {
+    QByteArray command;
+    MPDChunkHandler chunkHandler;
+    MPDResponseHandler handler;
+    qint64 sentAt;
+  };
+
+  QTcpSocket *tcpSocket_;
+  QLocalSocket *localSocket_;
+  // the transport of the current connection, one of the above
+  QIODevice *device_;
+  bool keepAlive_;
   QString hostname_;
   quint16 port_;
   QString passwd_;
-  QPair<QByteArray, bool> mpdCmdReply_;
+  QQueue<PendingCommand> pendingCommands_;
+  // Replies are received into one reusable buffer. replyStart_ is where the
+  // unfinished reply begins, scanPos_ the first line not scanned yet.
+  QByteArray readBuffer_;
+  int replyStart_;
+  int scanPos_;
+  // bumped whenever the buffer is dropped, e.g. by a handler disconnecting
+  quint32 bufferEpoch_;
+  QTimer responseTimer_;
+  bool responseTimeoutEnabled_;
+  QElapsedTimer clock_;
+  qint64 latency_;
+  bool healthy_;
   static const int socketReadTimeOut_;
   static const int socketMaxReadAttempt_;
+  static const int readBufferSize_;
+  static const int maxReadBufferCapacity_;
+
+  void close();
+  void enqueueCommand(const QByteArray &command,
+                      const MPDChunkHandler &chunkHandler,
+                      const MPDResponseHandler &handler);
+  bool waitForPendingCommands();
+  void failPendingCommands();
+  // Hands out [replyStart_, end) of the buffer, without a copy when the
+  // reply is all that is buffered.
+  QByteArray takeReply(const int end);
+  void deliverChunk(const MPDChunkHandler &chunkHandler, const int end);
+  void compactReadBuffer();
+  void resetReadBuffer();
+  void setHealthy(const bool healthy);
 };
 
 #endif  // MPDSOCKET_H
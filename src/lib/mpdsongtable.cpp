@@ -0,0 +1,124 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "mpdsongtable.h"
+#include "mpdmodel.h"
+
+MPDSongTable::MPDSongTable() {
+  values_.append(QString());
+}
+
+void MPDSongTable::reserve(const int songs) {
+  file_.reserve(songs);
+  title_.reserve(songs);
+  track_.reserve(songs);
+  disc_.reserve(songs);
+  date_.reserve(songs);
+  time_.reserve(songs);
+  albumId_.reserve(songs);
+  name_.reserve(songs);
+  comment_.reserve(songs);
+  lastModified_.reserve(songs);
+  for (int i = 0; i < tagCount_; i++) tags_[i].reserve(songs);
+}
+
+quint32 MPDSongTable::append(const MPDSongMetadata &song) {
+  const quint32 id = static_cast<quint32>(file_.size());
+  file_.append(song.file);
+  title_.append(song.title);
+  track_.append(song.track);
+  disc_.append(song.disc);
+  date_.append(song.date);
+  time_.append(song.time);
+  albumId_.append(song.albumId);
+  name_.append(song.name);
+  comment_.append(song.comment);
+  lastModified_.append(song.lastModified);
+  tags_[static_cast<int>(Tag::Artist)].append(valueId(song.artist));
+  tags_[static_cast<int>(Tag::Album)].append(valueId(song.album));
+  tags_[static_cast<int>(Tag::AlbumArtist)].append(valueId(song.albumArtist));
+  tags_[static_cast<int>(Tag::Genre)].append(valueId(song.genre));
+  tags_[static_cast<int>(Tag::Composer)].append(valueId(song.composer));
+  tags_[static_cast<int>(Tag::Performer)].append(valueId(song.performer));
+  return id;
+}
+
+MPDSongMetadata MPDSongTable::song(const quint32 song) const {
+  MPDSongMetadata metadata;
+  metadata.file = file_.at(song);
+  metadata.artist = tag(Tag::Artist, song);
+  metadata.album = tag(Tag::Album, song);
+  metadata.albumId = albumId_.at(song);
+  metadata.albumArtist = tag(Tag::AlbumArtist, song);
+  metadata.title = title_.at(song);
+  metadata.track = track_.at(song);
+  metadata.name = name_.at(song);
+  metadata.genre = tag(Tag::Genre, song);
+  metadata.date = date_.at(song);
+  metadata.composer = tag(Tag::Composer, song);
+  metadata.performer = tag(Tag::Performer, song);
+  metadata.comment = comment_.at(song);
+  metadata.disc = disc_.at(song);
+  metadata.time = time_.at(song);
+  metadata.lastModified = lastModified_.at(song);
+  return metadata;
+}
+
+QHash<quint32, int> MPDSongTable::count(const Tag tag) const {
+  // values are dense, so counting needs no hashing until the end
+  QVector<int> counts(values_.size(), 0);
+  int *const perValue = counts.data();
+  const QVector<quint32> &tagColumn = column(tag);
+  const quint32 *const ids = tagColumn.constData();
+  for (int i = 0, n = tagColumn.size(); i < n; i++) perValue[ids[i]]++;
+
+  QHash<quint32, int> facets;
+  for (int i = 0; i < counts.size(); i++) {
+    if (counts.at(i) > 0) facets.insert(static_cast<quint32>(i), counts.at(i));
+  }
+  return facets;
+}
+
+QVector<quint32> MPDSongTable::filter(const Tag tag,
+                                      const QString &value) const {
+  QVector<quint32> songs;
+  // the value need not be pooled, so it is looked for by its text
+  const int wanted = values_.indexOf(value);
+  if (wanted == -1) return songs;
+
+  const QVector<quint32> &tagColumn = column(tag);
+  const quint32 *const ids = tagColumn.constData();
+  for (int i = 0, n = tagColumn.size(); i < n; i++) {
+    if (ids[i] == static_cast<quint32>(wanted)) {
+      songs.append(static_cast<quint32>(i));
+    }
+  }
+  return songs;
+}
+
+quint32 MPDSongTable::valueId(const QString &value) {
+  if (value.isEmpty()) return 0;
+  // values_ holds a reference, so the data stays where it is meanwhile
+  const QHash<const QChar *, quint32>::const_iterator it =
+      valueIds_.constFind(value.constData());
+  if (it != valueIds_.constEnd()) return it.value();
+
+  const quint32 id = static_cast<quint32>(values_.size());
+  values_.append(value);
+  valueIds_.insert(value.constData(), id);
+  return id;
+}
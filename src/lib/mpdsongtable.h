@@ -0,0 +1,104 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MPDSONGTABLE_H
+#define MPDSONGTABLE_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+struct MPDSongMetadata;
+
+// The songs of a library stored column by column, a song id is its row.
+// Tags that repeat across songs are stored as ids of their distinct values,
+// so sorting, filtering & counting by them are loops over integer columns.
+// Tag values are expected to come from MPDStringPool, equal values then
+// share their data & are told apart by it without comparing or hashing text.
+class MPDSongTable {
+ public:
+  enum class Tag { Artist, Album, AlbumArtist, Genre, Composer, Performer };
+
+  MPDSongTable();
+
+  void reserve(const int songs);
+  // Appends the song, ids are dense & handed out from 0 on
+  quint32 append(const MPDSongMetadata &song);
+  int size() const { return file_.size(); }
+  // the song as it was appended, without its queue id & position
+  MPDSongMetadata song(const quint32 song) const;
+
+  const QString &file(const quint32 song) const { return file_.at(song); }
+  const QString &title(const quint32 song) const { return title_.at(song); }
+  quint16 track(const quint32 song) const { return track_.at(song); }
+  quint8 disc(const quint32 song) const { return disc_.at(song); }
+  quint16 date(const quint32 song) const { return date_.at(song); }
+  quint16 time(const quint32 song) const { return time_.at(song); }
+  const QString &albumId(const quint32 song) const {
+    return albumId_.at(song);
+  }
+  const QString &name(const quint32 song) const { return name_.at(song); }
+  const QString &comment(const quint32 song) const {
+    return comment_.at(song);
+  }
+  const QString &lastModified(const quint32 song) const {
+    return lastModified_.at(song);
+  }
+  const QString &tag(const Tag tag, const quint32 song) const {
+    return values_.at(column(tag).at(song));
+  }
+
+  // whole columns, indexed by song id
+  const QVector<quint32> &column(const Tag tag) const {
+    return tags_[static_cast<int>(tag)];
+  }
+  const QVector<quint16> &trackColumn() const { return track_; }
+  const QVector<quint8> &discColumn() const { return disc_; }
+  // the distinct value a tag column refers to
+  const QString &value(const quint32 valueId) const {
+    return values_.at(valueId);
+  }
+  // number of distinct values of all tags, ids are dense from 0 on
+  int valueCount() const { return values_.size(); }
+
+  // number of songs per value id of the tag
+  QHash<quint32, int> count(const Tag tag) const;
+  // ids of the songs with the given tag value, ascending
+  QVector<quint32> filter(const Tag tag, const QString &value) const;
+
+ private:
+  static const int tagCount_ = 6;
+
+  QVector<QString> file_;
+  QVector<QString> title_;
+  QVector<quint16> track_;
+  QVector<quint8> disc_;
+  QVector<quint16> date_;
+  QVector<quint16> time_;
+  QVector<QString> albumId_;
+  QVector<QString> name_;
+  QVector<QString> comment_;
+  QVector<QString> lastModified_;
+  QVector<quint32> tags_[tagCount_];
+  // distinct tag values, 0 is the empty value
+  QVector<QString> values_;
+  // value ids by the data of the pooled values
+  QHash<const QChar *, quint32> valueIds_;
+
+  quint32 valueId(const QString &value);
+};
+
+#endif  // MPDSONGTABLE_H
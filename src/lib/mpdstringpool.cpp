@@ -0,0 +1,59 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "mpdstringpool.h"
+
+#include <QMutexLocker>
+
+MPDStringPool::MPDStringPool() {}
+
+MPDStringPool &MPDStringPool::instance() {
+  static MPDStringPool pool;
+  return pool;
+}
+
+QString MPDStringPool::intern(const char *value, const int length) {
+  if (length == 0) return QString();
+
+  QMutexLocker locker(&mutex_);
+  // looked up without copying the value, only new values are copied
+  QHash<QByteArray, QString>::const_iterator it =
+      strings_.constFind(QByteArray::fromRawData(value, length));
+  if (it != strings_.constEnd()) return it.value();
+  return strings_
+      .insert(QByteArray(value, length), QString::fromUtf8(value, length))
+      .value();
+}
+
+void MPDStringPool::prune() {
+  QMutexLocker locker(&mutex_);
+  // the pool's copy is the only reference left when it is detached, nobody
+  // can get hold of it meanwhile as that goes through the locked pool
+  QHash<QByteArray, QString>::iterator it = strings_.begin();
+  while (it != strings_.end()) {
+    if (it.value().isDetached()) {
+      it = strings_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+int MPDStringPool::size() const {
+  QMutexLocker locker(&mutex_);
+  return strings_.size();
+}
@@ -0,0 +1,46 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MPDSTRINGPOOL_H
+#define MPDSTRINGPOOL_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+// Process wide pool of tag values. Artist, album & the like repeat across
+// thousands of songs, interned they all share one implicitly shared QString
+// instead of holding a copy each. Usable from any thread.
+class MPDStringPool {
+ public:
+  static MPDStringPool &instance();
+
+  // The pooled string for the UTF-8 value, which is decoded only once
+  QString intern(const char *value, const int length);
+  // Drops the strings nobody but the pool refers to anymore
+  void prune();
+  int size() const;
+
+ private:
+  MPDStringPool();
+  Q_DISABLE_COPY(MPDStringPool)
+
+  mutable QMutex mutex_;
+  QHash<QByteArray, QString> strings_;
+};
+
+#endif  // MPDSTRINGPOOL_H
@@ -35,48 +35,51 @@ PlaybackController::PlaybackController(QObject *parent,
 
 PlaybackController::~PlaybackController() {}
 
-bool PlaybackController::next() const {
-  return mpdSocket_->sendCommand(nextCmd).second;
+void PlaybackController::next(const MPDResponseHandler &handler) const {
+  mpdSocket_->sendCommand(nextCmd, handler);
 }
 
-bool PlaybackController::pause(quint8 toggle) const {
-  return mpdSocket_->sendCommand(pauseCmd + " " + QByteArray::number(toggle))
-      .second;
+void PlaybackController::pause(quint8 toggle,
+                               const MPDResponseHandler &handler) const {
+  mpdSocket_->sendCommand(pauseCmd + " " + QByteArray::number(toggle),
+                          handler);
 }
 
-bool PlaybackController::play(quint32 song) {
-  return mpdSocket_->sendCommand(playCmd + " " + QByteArray::number(song))
-      .second;
+void PlaybackController::play(quint32 song,
+                              const MPDResponseHandler &handler) {
+  mpdSocket_->sendCommand(playCmd + " " + QByteArray::number(song), handler);
 }
 
-bool PlaybackController::playId(quint32 songid) {
-  return mpdSocket_->sendCommand(playIdCmd + " " + QByteArray::number(songid))
-      .second;
+void PlaybackController::playId(quint32 songid,
+                                const MPDResponseHandler &handler) {
+  mpdSocket_->sendCommand(playIdCmd + " " + QByteArray::number(songid),
+                          handler);
 }
 
-bool PlaybackController::previous() {
-  return mpdSocket_->sendCommand(previousCmd).second;
+void PlaybackController::previous(const MPDResponseHandler &handler) {
+  mpdSocket_->sendCommand(previousCmd, handler);
 }
 
-bool PlaybackController::seek(quint32 song, quint32 time) {
-  return mpdSocket_
-      ->sendCommand(seekCmd + " " + QByteArray::number(song) + " " +
-                    QByteArray::number(time))
-      .second;
+void PlaybackController::seek(quint32 song, quint32 time,
+                              const MPDResponseHandler &handler) {
+  mpdSocket_->sendCommand(seekCmd + " " + QByteArray::number(song) + " " +
+                              QByteArray::number(time),
+                          handler);
 }
 
-bool PlaybackController::seekId(quint32 songid, quint32 time) {
-  return mpdSocket_
-      ->sendCommand(seekIdCmd + " " + QByteArray::number(songid) + " " +
-                    QByteArray::number(time))
-      .second;
+void PlaybackController::seekId(quint32 songid, quint32 time,
+                                const MPDResponseHandler &handler) {
+  mpdSocket_->sendCommand(seekIdCmd + " " + QByteArray::number(songid) + " " +
+                              QByteArray::number(time),
+                          handler);
 }
 
-bool PlaybackController::seekCur(quint32 time) {
-  return mpdSocket_->sendCommand(seekCurCmd + " " + QByteArray::number(time))
-      .second;
+void PlaybackController::seekCur(quint32 time,
+                                 const MPDResponseHandler &handler) {
+  mpdSocket_->sendCommand(seekCurCmd + " " + QByteArray::number(time),
+                          handler);
 }
 
-bool PlaybackController::stop() {
-  return mpdSocket_->sendCommand(stopCmd).second;
+void PlaybackController::stop(const MPDResponseHandler &handler) {
+  mpdSocket_->sendCommand(stopCmd, handler);
 }
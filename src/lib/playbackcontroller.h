@@ -19,7 +19,8 @@
 
 #include <QObject>
 #include <memory>
-class MPDSocket;
+
+#include "mpdsocket.h"
 
 class PlaybackController : QObject {
   Q_OBJECT
@@ -29,15 +30,21 @@ class PlaybackController : QObject {
       std::shared_ptr<MPDSocket> mpdSocket = nullptr);
   ~PlaybackController();
  public slots:
-  bool next() const;
-  bool pause(quint8 toggle) const;
-  bool play(quint32 song);
-  bool playId(quint32 songid);
-  bool previous();
-  bool seek(quint32 song, quint32 time);
-  bool seekId(quint32 songid, quint32 time);
-  bool seekCur(quint32 time);
-  bool stop();
+  void next(const MPDResponseHandler &handler = MPDResponseHandler()) const;
+  void pause(quint8 toggle,
+             const MPDResponseHandler &handler = MPDResponseHandler()) const;
+  void play(quint32 song,
+            const MPDResponseHandler &handler = MPDResponseHandler());
+  void playId(quint32 songid,
+              const MPDResponseHandler &handler = MPDResponseHandler());
+  void previous(const MPDResponseHandler &handler = MPDResponseHandler());
+  void seek(quint32 song, quint32 time,
+            const MPDResponseHandler &handler = MPDResponseHandler());
+  void seekId(quint32 songid, quint32 time,
+              const MPDResponseHandler &handler = MPDResponseHandler());
+  void seekCur(quint32 time,
+               const MPDResponseHandler &handler = MPDResponseHandler());
+  void stop(const MPDResponseHandler &handler = MPDResponseHandler());
 
  private:
   std::shared_ptr<MPDSocket> mpdSocket_;
@@ -39,39 +39,43 @@ PlaybackOptionsController::PlaybackOptionsController(
 
 PlaybackOptionsController::~PlaybackOptionsController() {}
 
-bool PlaybackOptionsController::consume(quint8 toggle) {
-  return mpdSocket_->sendCommand(consumeCmd + " " + QByteArray::number(toggle))
-      .second;
+void PlaybackOptionsController::consume(quint8 toggle,
+                                        const MPDResponseHandler &handler) {
+  mpdSocket_->sendCommand(consumeCmd + " " + QByteArray::number(toggle),
+                          handler);
 }
 
-bool PlaybackOptionsController::crossfade(int seconds) {
-  return mpdSocket_
-      ->sendCommand(crossfadeCmd + " " + QByteArray::number(seconds))
-      .second;
+void PlaybackOptionsController::crossfade(int seconds,
+                                          const MPDResponseHandler &handler) {
+  mpdSocket_->sendCommand(crossfadeCmd + " " + QByteArray::number(seconds),
+                          handler);
 }
 
-bool PlaybackOptionsController::random(quint8 toggle) {
-  return mpdSocket_->sendCommand(randomCmd + " " + QByteArray::number(toggle))
-      .second;
+void PlaybackOptionsController::random(quint8 toggle,
+                                       const MPDResponseHandler &handler) {
+  mpdSocket_->sendCommand(randomCmd + " " + QByteArray::number(toggle),
+                          handler);
 }
 
-bool PlaybackOptionsController::repeat(quint8 toggle) {
-  return mpdSocket_->sendCommand(repeatCmd + " " + QByteArray::number(toggle))
-      .second;
+void PlaybackOptionsController::repeat(quint8 toggle,
+                                       const MPDResponseHandler &handler) {
+  mpdSocket_->sendCommand(repeatCmd + " " + QByteArray::number(toggle),
+                          handler);
 }
 
-bool PlaybackOptionsController::setvol(quint8 vol) {
-  return mpdSocket_->sendCommand(setvolCmd + " " + QByteArray::number(vol))
-      .second;
+void PlaybackOptionsController::setvol(quint8 vol,
+                                       const MPDResponseHandler &handler) {
+  mpdSocket_->sendCommand(setvolCmd + " " + QByteArray::number(vol), handler);
 }
 
-bool PlaybackOptionsController::single(quint8 toggle) {
-  return mpdSocket_->sendCommand(singleCmd + " " + QByteArray::number(toggle))
-      .second;
+void PlaybackOptionsController::single(quint8 toggle,
+                                       const MPDResponseHandler &handler) {
+  mpdSocket_->sendCommand(singleCmd + " " + QByteArray::number(toggle),
+                          handler);
 }
 
-bool PlaybackOptionsController::volume(int volChange) {
-  return mpdSocket_
-      ->sendCommand(volumeCmd + " " + QByteArray::number(volChange))
-      .second;
+void PlaybackOptionsController::volume(int volChange,
+                                       const MPDResponseHandler &handler) {
+  mpdSocket_->sendCommand(volumeCmd + " " + QByteArray::number(volChange),
+                          handler);
 }
@@ -20,7 +20,7 @@
 #include <QObject>
 #include <memory>
 
-class MPDSocket;
+#include "mpdsocket.h"
 
 class PlaybackOptionsController : public QObject {
   Q_OBJECT
@@ -33,17 +33,24 @@ class PlaybackOptionsController : public QObject {
  signals:
 
  public slots:
-  bool consume(quint8 toggle);
-  bool crossfade(int seconds);
+  void consume(quint8 toggle,
+               const MPDResponseHandler &handler = MPDResponseHandler());
+  void crossfade(int seconds,
+                 const MPDResponseHandler &handler = MPDResponseHandler());
   //void mixrampdb();
   //void mixrampdelay();
-  bool random(quint8 toggle);
-  bool repeat(quint8 toggle);
-  bool setvol(quint8 vol);
-  bool single(quint8 toggle);
+  void random(quint8 toggle,
+              const MPDResponseHandler &handler = MPDResponseHandler());
+  void repeat(quint8 toggle,
+              const MPDResponseHandler &handler = MPDResponseHandler());
+  void setvol(quint8 vol,
+              const MPDResponseHandler &handler = MPDResponseHandler());
+  void single(quint8 toggle,
+              const MPDResponseHandler &handler = MPDResponseHandler());
   //void replay_gain_mode();
   //void replay_gain_status();
-  bool volume(int volChange);
+  void volume(int volChange,
+              const MPDResponseHandler &handler = MPDResponseHandler());
 
  private:
   std::shared_ptr<MPDSocket> mpdSocket_;
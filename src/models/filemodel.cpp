@@ -110,7 +110,103 @@ QVariant FileModel::data(const QModelIndex &index, int role) const {
   return QVariant();
 }
 
-void FileModel::ViewUpdated() {
+bool FileModel::hasChildren(const QModelIndex &parent) const {
+  const Item *const parentItem = item(parent);
+  // an unlisted folder may have children
+  if (!parentItem->isFetched()) return true;
+  return parentItem->childCount() > 0;
+}
+
+bool FileModel::canFetchMore(const QModelIndex &parent) const {
+  return !item(parent)->isFetched();
+}
+
+void FileModel::fetchMore(const QModelIndex &parent) {
+  const Item *const parentItem = item(parent);
+  if (parentItem->isFetched()) return;
+
+  const QString path = parentItem->path();
+  if (pendingPaths_.contains(path)) return;
+  pendingPaths_.insert(path);
+  emit directoryRequested(path);
+}
+
+void FileModel::ViewUpdated(RootItem *rootitem) {
   beginResetModel();
+  rootItem = rootitem;
+  pendingPaths_.clear();
   endResetModel();
 }
+
+void FileModel::directoryFetched(const QString &path,
+                                 const QStringList &directories,
+                                 const QStringList &files) {
+  // the tree may have been replaced since the folder was requested
+  if (!pendingPaths_.remove(path)) return;
+  Item *const dir = folder(path);
+  if (!dir || dir->isFetched()) return;
+
+  // A folder filled from the cached library already holds the folders &
+  // files with songs, only the others are added
+  QSet<QString> heldDirectories;
+  QSet<QString> heldFiles;
+  for (int i = 0; i < dir->childCount(); i++) {
+    const Item *const child = dir->child(i);
+    if (child->type() == Item::Type::TypeFolder) {
+      heldDirectories.insert(child->name());
+    } else {
+      heldFiles.insert(child->name());
+    }
+  }
+  QStringList newDirectories;
+  for (const QString &directory : directories) {
+    if (!heldDirectories.contains(directory)) newDirectories << directory;
+  }
+  QStringList newFiles;
+  for (const QString &file : files) {
+    if (!heldFiles.contains(file)) newFiles << file;
+  }
+
+  const QModelIndex parent =
+      dir == rootItem ? QModelIndex() : createIndex(dir->row(), 0, dir);
+  const int count = newDirectories.size() + newFiles.size();
+  if (count == 0) {
+    // no longer shown as expandable if it is empty
+    dir->setFetched(true);
+    if (parent.isValid()) emit dataChanged(parent, parent);
+    return;
+  }
+
+  const int first = dir->childCount();
+  beginInsertRows(parent, first, first + count - 1);
+  for (const QString &directory : newDirectories) {
+    dir->createDirectory(directory);
+  }
+  for (const QString &file : newFiles) dir->insertFile(file);
+  dir->setFetched(true);
+  endInsertRows();
+}
+
+Item *FileModel::item(const QModelIndex &index) const {
+  if (!index.isValid()) return rootItem;
+  return static_cast<Item *>(index.internalPointer());
+}
+
+Item *FileModel::folder(const QString &path) const {
+  Item *dir = rootItem;
+  if (path.isEmpty()) return dir;
+
+  for (const QString &name : path.split('/')) {
+    Item *next = nullptr;
+    for (int i = 0; i < dir->childCount(); i++) {
+      Item *const child = dir->child(i);
+      if (child->type() == Item::Type::TypeFolder && child->name() == name) {
+        next = child;
+        break;
+      }
+    }
+    if (!next) return nullptr;
+    dir = next;
+  }
+  return dir;
+}
@@ -22,9 +22,12 @@
 
 #include <QAbstractItemModel>
 #include <QList>
+#include <QSet>
 #include <QString>
+#include <QStringList>
 #include <QVariant>
 
+class Item;
 class RootItem;
 
 class FileModel : public QAbstractItemModel {
@@ -40,12 +43,29 @@ class FileModel : public QAbstractItemModel {
   int rowCount(const QModelIndex& parent = QModelIndex()) const;
   int columnCount(const QModelIndex&) const;
   QVariant data(const QModelIndex&, int) const;
+  // folders are listed when they are first expanded
+  bool hasChildren(const QModelIndex& parent = QModelIndex()) const;
+  bool canFetchMore(const QModelIndex& parent) const;
+  void fetchMore(const QModelIndex& parent);
 
  public slots:
-  void ViewUpdated();
+  // switches to the freshly built tree, the caller frees the old one
+  void ViewUpdated(RootItem *rootitem);
+  // fills the folder at path with what MPD listed
+  void directoryFetched(const QString& path, const QStringList& directories,
+                        const QStringList& files);
+
+ signals:
+  void directoryRequested(const QString& path);
 
  private:
-  const RootItem* rootItem;
+  RootItem* rootItem;
+  // folders requested but not listed yet
+  QSet<QString> pendingPaths_;
+
+  Item* item(const QModelIndex& index) const;
+  // nullptr if the tree has no folder at path
+  Item* folder(const QString& path) const;
 };
 
 #endif
@@ -0,0 +1,104 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "librarymimedata.h"
+#include "../lib/mpdlibrarymodel.h"
+
+#include <QDataStream>
+#include <QSet>
+
+static const QString songsMimeType("application/qtmpc_songs_filename_text");
+
+LibraryMimeData::LibraryMimeData(const MPDLibrarySnapshot &library,
+                                 const QList<const MusicLibraryItem *> &items)
+    : library_(library), items_(items) {}
+
+QVector<quint32> LibraryMimeData::songs() const {
+  QVector<quint32> songs;
+  QSet<quint32> added;
+  const auto add = [&songs, &added](const quint32 song) {
+    if (added.contains(song)) return;
+    added.insert(song);
+    songs.append(song);
+  };
+
+  for (const MusicLibraryItem *item : items_) {
+    switch (item->type()) {
+      case MusicLibraryItem::Type::TypeArtist:
+        for (int i = 0; i < item->childCount(); i++) {
+          for (const quint32 song : albumTracks(
+                   static_cast<MusicLibraryItemAlbum *>(item->child(i)))) {
+            add(song);
+          }
+        }
+        break;
+      case MusicLibraryItem::Type::TypeAlbum:
+        for (const quint32 song :
+             albumTracks(static_cast<const MusicLibraryItemAlbum *>(item))) {
+          add(song);
+        }
+        break;
+      case MusicLibraryItem::Type::TypeSong:
+        add(static_cast<const MusicLibraryItemSong *>(item)->song());
+        break;
+      default:
+        break;
+    }
+  }
+  return songs;
+}
+
+QStringList LibraryMimeData::filenames() const {
+  const MPDSongTable *const table = library_->songs();
+  const QVector<quint32> songs = this->songs();
+  QStringList filenames;
+  filenames.reserve(songs.size());
+  for (const quint32 song : songs) filenames << table->file(song);
+  return filenames;
+}
+
+QStringList LibraryMimeData::formats() const {
+  return QStringList() << songsMimeType;
+}
+
+bool LibraryMimeData::hasFormat(const QString &mimeType) const {
+  return mimeType == songsMimeType;
+}
+
+QVariant LibraryMimeData::retrieveData(const QString &mimeType,
+                                       QVariant::Type type) const {
+  if (mimeType != songsMimeType) {
+    return QMimeData::retrieveData(mimeType, type);
+  }
+
+  // streamed last to first, like the library used to
+  QByteArray encodedData;
+  QDataStream stream(&encodedData, QIODevice::WriteOnly);
+  const QStringList filenames = this->filenames();
+  for (int i = filenames.size() - 1; i >= 0; i--) stream << filenames.at(i);
+  return encodedData;
+}
+
+QVector<quint32> LibraryMimeData::albumTracks(
+    const MusicLibraryItemAlbum *album) const {
+  // the library keeps the songs of an album in disc & track order
+  QVector<quint32> tracks;
+  tracks.reserve(album->childCount());
+  for (int i = 0; i < album->childCount(); i++) {
+    tracks.append(static_cast<MusicLibraryItemSong *>(album->child(i))->song());
+  }
+  return tracks;
+}
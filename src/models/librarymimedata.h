@@ -0,0 +1,59 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LIBRARYMIMEDATA_H
+#define LIBRARYMIMEDATA_H
+
+#include <QList>
+#include <QMimeData>
+#include <QStringList>
+#include <QVector>
+
+#include "../lib/mpdlibrarysearcher.h"
+
+class MusicLibraryItem;
+class MusicLibraryItemAlbum;
+
+// Songs dragged from the library. Only the dragged artists, albums & songs
+// are held, along with the library they belong to, which stays as it is
+// while shared. Their files are looked up once dropped; other receivers get
+// the filename stream of the songs mime type, built when asked for.
+class LibraryMimeData : public QMimeData {
+  Q_OBJECT
+
+ public:
+  LibraryMimeData(const MPDLibrarySnapshot &library,
+                  const QList<const MusicLibraryItem *> &items);
+
+  // song table ids of the dragged songs in queue order, each once
+  QVector<quint32> songs() const;
+  QStringList filenames() const;
+
+  QStringList formats() const;
+  bool hasFormat(const QString &mimeType) const;
+
+ protected:
+  QVariant retrieveData(const QString &mimeType, QVariant::Type type) const;
+
+ private:
+  const MPDLibrarySnapshot library_;
+  const QList<const MusicLibraryItem *> items_;
+
+  // the songs of album in the order the library keeps them
+  QVector<quint32> albumTracks(const MusicLibraryItemAlbum *album) const;
+};
+
+#endif  // LIBRARYMIMEDATA_H
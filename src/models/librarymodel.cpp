@@ -1,21 +1,25 @@
+#include "lib/mpdlibrarybuilder.h"
 #include "lib/mpdlibrarymodel.h"
+#include "lib/mpdmodel.h"
+#include "lib/mpdstringpool.h"
+#include "librarymimedata.h"
 #include "librarymodel.h"
 
 #include <QDateTime>
 #include <QDebug>
-#include <QDir>
-#include <QFile>
 #include <QMimeData>
 #include <QStringList>
-#include <QStringRef>
-#include <QXmlStreamReader>
-#include <QXmlStreamWriter>
 
 LibraryModel::LibraryModel(QObject *parent)
     : QAbstractItemModel(parent),
-      rootItem(new MusicLibraryItemRoot("Artist/Album/Song")) {}
+      rootItem(new MusicLibraryItemRoot("Artist/Album/Song")),
+      pendingRoot_(nullptr),
+      builder_(nullptr) {}
 
-LibraryModel::~LibraryModel() { delete rootItem; }
+LibraryModel::~LibraryModel() {
+  delete builder_;
+  delete pendingRoot_;
+}
 
 QModelIndex LibraryModel::index(int row, int column,
                                      const QModelIndex &parent) const {
@@ -24,7 +28,7 @@ QModelIndex LibraryModel::index(int row, int column,
   const MusicLibraryItem *parentItem;
 
   if (!parent.isValid())
-    parentItem = rootItem;
+    parentItem = rootItem.get();
   else
     parentItem = static_cast<MusicLibraryItem *>(parent.internalPointer());
 
@@ -41,7 +45,7 @@ QModelIndex LibraryModel::parent(const QModelIndex &index) const {
       static_cast<MusicLibraryItem *>(index.internalPointer());
   MusicLibraryItem *const parentItem = childItem->parent();
 
-  if (parentItem == rootItem) return QModelIndex();
+  if (parentItem == rootItem.get()) return QModelIndex();
 
   return createIndex(parentItem->row(), 0, parentItem);
 }
@@ -60,7 +64,7 @@ int LibraryModel::rowCount(const QModelIndex &parent) const {
   const MusicLibraryItem *parentItem;
 
   if (!parent.isValid())
-    parentItem = rootItem;
+    parentItem = rootItem.get();
   else
     parentItem = static_cast<MusicLibraryItem *>(parent.internalPointer());
 
@@ -86,224 +90,140 @@ QVariant LibraryModel::data(const QModelIndex &index, int role) const {
   return item->data(index.column());
 }
 
-void LibraryModel::updateLibrary(QList<MusicLibraryItemArtist *> *items,
-                                      QDateTime db_update, bool fromFile) {
-  MusicLibraryItemArtist *item;
-
-  const MusicLibraryItemRoot *oldRoot = rootItem;
-  MusicLibraryItemRoot *const newRoot =
-      new MusicLibraryItemRoot("Artist / Album / Song");
-
-  while (items->size()) {
-    item = items->takeFirst();
-    item->setParent(newRoot);
-    newRoot->appendChild(item);
-  }
-
-  rootItem = newRoot;
-
-  delete items;
-  delete oldRoot;
-
+void LibraryModel::updateLibrary(MusicLibraryItemRoot *root,
+                                 QDateTime db_update, bool fromFile) {
   beginResetModel();
+  rootItem.reset(root);
   endResetModel();
+  // tag values only the replaced library used
+  MPDStringPool::instance().prune();
+  publishLibrary();
+
+  if (!fromFile) emit libraryReceived(rootItem, db_update);
+}
 
-  if (!fromFile) {
-    toXML(db_update);
+void LibraryModel::beginLibraryUpdate() {
+  delete builder_;
+  delete pendingRoot_;
+  pendingRoot_ = nullptr;
+  if (rootItem->childCount() > 0) {
+    pendingRoot_ = new MusicLibraryItemRoot("Artist / Album / Song");
+  } else if (rootItem.use_count() > 1) {
+    // the searcher may still read the empty library, fill a fresh one
+    beginResetModel();
+    rootItem.reset(new MusicLibraryItemRoot("Artist / Album / Song"));
+    endResetModel();
   }
+  builder_ =
+      new MusicLibraryBuilder(pendingRoot_ ? pendingRoot_ : rootItem.get());
 }
 
-/**
- * Writes the musiclibrarymodel to and xml file so we can store it on
- * disk for faster startup the next time
- *
- * @param filename The name of the file to write the xml to
- */
-void LibraryModel::toXML(const QDateTime db_update) {
-  // Check if dir exists
-  QDir savedir(QDir::home());
-  if (!savedir.exists(".QtMPC")) {
-    if (!savedir.mkdir(".QtMPC")) {
-      qWarning("Couldn't create directory for storing database file");
-      return;
+void LibraryModel::appendSongs(const QList<MPDSongMetadata> &songs) {
+  if (!builder_) return;
+  const bool inPlace = (pendingRoot_ == nullptr);
+  MusicLibraryItemRoot *const root = inPlace ? rootItem.get() : pendingRoot_;
+
+  // Songs arrive grouped by directory, so consecutive songs of the same
+  // album are inserted with a single row notification.
+  for (int first = 0, last = 0; first < songs.size(); first = last) {
+    const MPDSongMetadata &song = songs.at(first);
+    for (last = first + 1; last < songs.size(); last++) {
+      if (songs.at(last).artist != song.artist ||
+          songs.at(last).album != song.album)
+        break;
     }
-  }
 
-  // Create the filename
-  QString dir(QDir::toNativeSeparators(QDir::homePath()) + QDir::separator() +
-              ".QtMPC" + QDir::separator());
-  QString hostname = settings.value("connection/host").toString();
-  QString filename(QFile::encodeName(hostname + "_database.xml"));
-
-  // Open the file
-  QFile file(dir + filename);
-  file.open(QIODevice::WriteOnly);
-
-  // Write the header info
-  QXmlStreamWriter writer(&file);
-  writer.setAutoFormatting(true);
-  writer.writeStartDocument();
-  writer.writeDTD(
-      "<!DOCTYPE MPD_database SYSTEM "
-      "\"http://qtmpc.lowblog.nl/svn/database.dtd\">");
-
-  // Start with the document
-  writer.writeStartElement("MPD_database");
-  writer.writeAttribute("version", "1");
-  writer.writeAttribute("date", QString::number(db_update.toTime_t()));
-  // Loop over all artist, albums and tracks.
-  for (int i = 0; i < rootItem->childCount(); i++) {
-    MusicLibraryItemArtist *artist =
-        static_cast<MusicLibraryItemArtist *>(rootItem->child(i));
-    writer.writeStartElement("Artist");
-    writer.writeAttribute("name", artist->data(0).toString());
-    for (int j = 0; j < artist->childCount(); j++) {
-      MusicLibraryItemAlbum *album =
-          static_cast<MusicLibraryItemAlbum *>(artist->child(j));
-      writer.writeStartElement("Album");
-      writer.writeAttribute("title", album->data(0).toString());
-      for (int k = 0; k < album->childCount(); k++) {
-        MusicLibraryItemSong *track =
-            static_cast<MusicLibraryItemSong *>(album->child(k));
-        writer.writeEmptyElement("Track");
-        writer.writeAttribute("title", track->data(0).toString());
-        writer.writeAttribute("filename", track->file());
-        // Only write track number if it is set
-        if (track->track() != 0) {
-          writer.writeAttribute("track", QString::number(track->track()));
-        }
-        if (track->disc() != 0) {
-          writer.writeAttribute("disc", QString::number(track->disc()));
-        }
+    MusicLibraryItemArtist *artistItem = builder_->artist(song.artist);
+    MusicLibraryItemAlbum *albumItem =
+        artistItem ? builder_->album(artistItem, song.album) : nullptr;
+
+    // the first new level is inserted with everything below it in place
+    if (!artistItem) {
+      if (inPlace) {
+        beginInsertRows(QModelIndex(), root->childCount(), root->childCount());
+      }
+      artistItem = builder_->addArtist(song.artist);
+      albumItem = builder_->addAlbum(artistItem, song.album);
+      builder_->addSongs(albumItem, songs, first, last);
+    } else if (!albumItem) {
+      if (inPlace) {
+        beginInsertRows(
+            createIndex(builder_->row(artistItem), 0, artistItem),
+            artistItem->childCount(), artistItem->childCount());
       }
-      writer.writeEndElement();
+      albumItem = builder_->addAlbum(artistItem, song.album);
+      builder_->addSongs(albumItem, songs, first, last);
+    } else if (inPlace) {
+      // each song goes in its row, the album stays in track order
+      const QModelIndex albumIndex =
+          createIndex(builder_->row(albumItem), 0, albumItem);
+      for (int i = first; i < last; i++) {
+        const int row = builder_->songRow(albumItem, songs.at(i));
+        beginInsertRows(albumIndex, row, row);
+        builder_->addSong(albumItem, songs.at(i));
+        endInsertRows();
+      }
+      continue;
+    } else {
+      builder_->addSongs(albumItem, songs, first, last);
     }
-    writer.writeEndElement();
+    if (inPlace) endInsertRows();
   }
-
-  writer.writeEndElement();
-  writer.writeEndDocument();
-  file.close();
-
-  emit xmlWritten(db_update);
+  // indexed batch by batch rather than all at once when first searched
+  root->searchIndex()->update();
 }
 
-/**
- * Read an xml file from disk.
- *
- * @param filename The name of the xmlfile to read the db from
- *
- * @return true on succesfull parsing, false otherwise
- * TODO: check for hostname
- * TODO: check for database version
- */
-bool LibraryModel::fromXML(const QDateTime db_update) {
-  QString dir(QDir::toNativeSeparators(QDir::homePath()) + QDir::separator() +
-              ".QtMPC" + QDir::separator());
-  QString hostname = settings.value("connection/host").toString();
-  QString filename(QFile::encodeName(hostname + "_database.xml"));
-
-  // Check if file exists
-  if (!QFile::exists(dir + filename)) return false;
-
-  QFile file(dir + filename);
-
-  QList<MusicLibraryItemArtist *> *artists =
-      new QList<MusicLibraryItemArtist *>;
-  MusicLibraryItemArtist *artistItem = nullptr;
-  MusicLibraryItemAlbum *albumItem = nullptr;
-  MusicLibraryItemSong *songItem = nullptr;
-
-  file.open(QIODevice::ReadOnly);
-
-  QXmlStreamReader reader(&file);
-  bool valid = false;
-
-  while (!reader.atEnd()) {
-    reader.readNext();
+void LibraryModel::publishLibrary() {
+  rootItem->searchIndex()->update();
+  emit libraryChanged(rootItem);
+}
 
-    /**
-     * TODO: CHECK FOR ERRORS
-     */
-    if (reader.error()) {
-      qDebug() << reader.errorString();
+void LibraryModel::finishLibraryUpdate(const bool complete,
+                                       QDateTime db_update) {
+  // the songs of the library filled in view are in order already
+  if (builder_ && !pendingRoot_) sortInView([this]() { builder_->sort(); });
+  delete builder_;
+  builder_ = nullptr;
+
+  if (pendingRoot_) {
+    // The library received aside is ordered off the GUI thread before it
+    // takes over, an incomplete one is dropped in favour of the one we have
+    if (complete) {
+      emit libraryCompleted(pendingRoot_, db_update);
     } else {
-      if (reader.isStartElement()) {
-        QString element = reader.name().toString();
-
-        if (element == "MPD_database") {
-          quint32 version =
-              reader.attributes().value("version").toString().toUInt();
-          quint32 time_t =
-              reader.attributes().value("date").toString().toUInt();
-
-          // Incompatible version
-          if (version < 1) {
-            break;
-          }
-
-          // Outdated
-          if (time_t != db_update.toTime_t()) break;
-
-          valid = true;
-        }
-
-        // Only check for other elements when we are valid!
-        if (valid) {
-          // New artist element. Create it an add it
-          if (element == "Artist") {
-            QString artist_string =
-                reader.attributes().value("name").toString();
-
-            artistItem = new MusicLibraryItemArtist(artist_string);
-            artists->append(artistItem);
-          }
-
-          // New album element. Create it and add it to the artist
-          if (element == "Album") {
-            QString album_string =
-                reader.attributes().value("title").toString();
-
-            albumItem = new MusicLibraryItemAlbum(album_string, artistItem);
-            artistItem->appendChild(albumItem);
-          }
-
-          // New track element. Create it and add it to the album
-          if (element == "Track") {
-            QString track_name = reader.attributes().value("title").toString();
-            songItem = new MusicLibraryItemSong(track_name, albumItem);
-
-            QString track_file =
-                reader.attributes().value("filename").toString();
-            songItem->setFile(track_file);
-
-            QString track_number_string =
-                reader.attributes().value("track").toString();
-            QString disc_number_string =
-                reader.attributes().value("disc").toString();
-            if (!track_number_string.isEmpty()) {
-              quint32 track_number = track_number_string.toUInt();
-              quint32 disc_number = disc_number_string.toUInt();
-              songItem->setTrack(track_number);
-              songItem->setDisc(disc_number);
-            }
-
-            albumItem->appendChild(songItem);
-          }
-        }
-      }
+      delete pendingRoot_;
+      MPDStringPool::instance().prune();
     }
+    pendingRoot_ = nullptr;
+    return;
   }
+  publishLibrary();
 
-  // If not valid we need to cleanup
-  if (!valid) {
-    delete artists;
-    return false;
-  }
+  if (complete) emit libraryReceived(rootItem, db_update);
+}
 
-  file.close();
-  updateLibrary(artists, QDateTime(), true);
-  return true;
+void LibraryModel::updateAlbumOrder() {
+  // a library being filled in view is ordered once complete
+  if (builder_ && !pendingRoot_) return;
+  MusicLibraryBuilder builder(rootItem.get());
+  sortInView([&builder]() {
+    builder.sortAlbums(MusicLibraryBuilder::albumOrder());
+  });
+}
+
+void LibraryModel::sortInView(const std::function<void()> &sort) {
+  emit layoutAboutToBeChanged();
+  const QModelIndexList before = persistentIndexList();
+  sort();
+  QModelIndexList after;
+  after.reserve(before.size());
+  for (const QModelIndex &index : before) {
+    MusicLibraryItem *const item =
+        static_cast<MusicLibraryItem *>(index.internalPointer());
+    after.append(createIndex(item->row(), index.column(), item));
+  }
+  changePersistentIndexList(before, after);
+  emit layoutChanged();
 }
 
 Qt::ItemFlags LibraryModel::flags(const QModelIndex &index) const {
@@ -314,98 +234,18 @@ Qt::ItemFlags LibraryModel::flags(const QModelIndex &index) const {
 }
 
 /**
- * Convert the data at indexes into mimedata ready for transport
+ * Convert the data at indexes into mimedata ready for transport. Only the
+ * items are passed on, their songs are looked up once dropped.
  *
  * @param indexes The indexes to pack into mimedata
  * @return The mimedata
  */
 QMimeData *LibraryModel::mimeData(const QModelIndexList &indexes) const {
-  QMimeData *mimeData = new QMimeData();
-  QByteArray encodedData;
-
-  QDataStream stream(&encodedData, QIODevice::WriteOnly);
-  QStringList filenames;
-
-  foreach (QModelIndex index, indexes) {
-    MusicLibraryItem *item =
-        static_cast<MusicLibraryItem *>(index.internalPointer());
-
-    switch (item->type()) {
-      case MusicLibraryItem::Type::TypeArtist:
-        for (int i = 0; i < item->childCount(); i++) {
-          filenames << sortAlbumTracks(
-              static_cast<MusicLibraryItemAlbum *>(item->child(i)));
-        }
-        break;
-      case MusicLibraryItem::Type::TypeAlbum:
-        filenames << sortAlbumTracks(
-            static_cast<MusicLibraryItemAlbum *>(item));
-        break;
-      case MusicLibraryItem::Type::TypeSong:
-        if (item->type() == MusicLibraryItem::Type::TypeSong) {
-          if (!filenames.contains(
-                  static_cast<MusicLibraryItemSong *>(item)->file()))
-            filenames << static_cast<MusicLibraryItemSong *>(item)->file();
-        }
-        break;
-      default:
-        break;
-    }
-  }
-
-  for (int i = filenames.size() - 1; i >= 0; i--) {
-    stream << filenames.at(i);
-  }
-
-  mimeData->setData("application/qtmpc_songs_filename_text", encodedData);
-  return mimeData;
-}
-
-/**
- * Sort an album by its track numbers. All unnumberd tracks are added to the end
- *
- * @param album The album musiclibrary item
- */
-QStringList LibraryModel::sortAlbumTracks(
-    const MusicLibraryItemAlbum *album) const {
-  if (album->type() != MusicLibraryItem::Type::TypeAlbum) {
-    return QStringList();
+  QList<const MusicLibraryItem *> items;
+  items.reserve(indexes.size());
+  for (const QModelIndex &index : indexes) {
+    items.append(
+        static_cast<const MusicLibraryItem *>(index.internalPointer()));
   }
-
-  MusicLibraryItemAlbum *orderedTracks = new MusicLibraryItemAlbum("Album");
-  QStringList unorderedTracks;
-
-  for (int i = 0; i < album->childCount(); i++) {
-    MusicLibraryItemSong *track =
-        static_cast<MusicLibraryItemSong *>(album->child(i));
-    if (track->track() == static_cast<quint32>(0)) {
-      unorderedTracks << track->file();
-    }
-
-    bool insert = false;
-    for (int j = 0; j < orderedTracks->childCount(); j++) {
-      if (track->track() <
-          static_cast<MusicLibraryItemSong *>(orderedTracks->child(j))
-              ->track()) {
-        orderedTracks->insertChild(track, j);
-        insert = true;
-        break;
-      }
-    }
-
-    if (insert == false) {
-      orderedTracks->insertChild(track, orderedTracks->childCount());
-    }
-  }
-
-  QStringList tracks;
-  for (int i = 0; i < orderedTracks->childCount(); i++) {
-    tracks
-        << static_cast<MusicLibraryItemSong *>(orderedTracks->child(i))->file();
-  }
-  tracks << unorderedTracks;
-
-  orderedTracks->clearChildren();
-  delete orderedTracks;
-  return tracks;
+  return new LibraryMimeData(rootItem, items);
 }
@@ -4,11 +4,16 @@
 #include <QAbstractItemModel>
 #include <QDateTime>
 #include <QMimeData>
-#include <QSettings>
+#include <functional>
+#include <memory>
 
+#include "../lib/mpdlibrarysearcher.h"
+
+class MusicLibraryBuilder;
 class MusicLibraryItemAlbum;
 class MusicLibraryItemArtist;
 class MusicLibraryItemRoot;
+struct MPDSongMetadata;
 
 class LibraryModel : public QAbstractItemModel {
   Q_OBJECT
@@ -23,24 +28,47 @@ class LibraryModel : public QAbstractItemModel {
   int rowCount(const QModelIndex &parent = QModelIndex()) const;
   int columnCount(const QModelIndex &) const;
   QVariant data(const QModelIndex &, int) const;
-  bool fromXML(const QDateTime db_update);
 
   Qt::ItemFlags flags(const QModelIndex &index) const;
   QMimeData *mimeData(const QModelIndexList &indexes) const;
 
  public slots:
-  void updateLibrary(QList<MusicLibraryItemArtist *> *items,
+  // takes over root
+  void updateLibrary(MusicLibraryItemRoot *root,
                      QDateTime db_update = QDateTime(), bool fromFile = false);
+  // Incremental update while MPD is still sending the library. An empty
+  // library is filled in place so the view populates right away, otherwise
+  // the current one stays in place until the update is complete.
+  void beginLibraryUpdate();
+  void appendSongs(const QList<MPDSongMetadata> &songs);
+  void finishLibraryUpdate(const bool complete, QDateTime db_update);
+  // reorders the albums shown after the album order setting changed
+  void updateAlbumOrder();
 
  signals:
-  void xmlWritten(QDateTime db_update);
+  // a complete library took over, only the order of its albums changes
+  // from now on
+  void libraryChanged(const MPDLibrarySnapshot &library);
+  // A library received aside is complete. It is to be ordered off the GUI
+  // thread & handed back to updateLibrary(), which takes it over.
+  void libraryCompleted(MusicLibraryItemRoot *library, QDateTime db_update);
+  // the library that took over was received from MPD, to be cached
+  void libraryReceived(const MPDLibrarySnapshot &library,
+                       QDateTime db_update);
 
  private:
-  const MusicLibraryItemRoot *rootItem;
-  QSettings settings;
-  QStringList sortAlbumTracks(const MusicLibraryItemAlbum *album) const;
+  // shared with the searcher once complete
+  std::shared_ptr<MusicLibraryItemRoot> rootItem;
+  // the library being received, nullptr while filling rootItem in place
+  MusicLibraryItemRoot *pendingRoot_;
+  // indexes the library being received, nullptr outside of an update
+  MusicLibraryBuilder *builder_;
 
-  void toXML(const QDateTime db_update);
+  // hands the current library on to be searched
+  void publishLibrary();
+  // Reorders the library shown as a layout change, which keeps the rows
+  // expanded & selected meanwhile
+  void sortInView(const std::function<void()> &sort);
 };
 
 #endif  // LIBRARYMODEL_H
@@ -0,0 +1,90 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "searchresultsmodel.h"
+
+#include <QDataStream>
+#include <QMimeData>
+#include <QStringList>
+
+#include <algorithm>
+
+SearchResultsModel::SearchResultsModel(QObject *parent)
+    : QAbstractListModel(parent), searchId_(0) {}
+
+int SearchResultsModel::rowCount(const QModelIndex &parent) const {
+  if (parent.isValid()) return 0;
+  return results_.size();
+}
+
+QVariant SearchResultsModel::data(const QModelIndex &index, int role) const {
+  if (!index.isValid() || index.row() >= results_.size()) return QVariant();
+
+  const MPDSearchResult &result = results_.at(index.row());
+  switch (role) {
+    case Qt::DisplayRole:
+      if (result.title.isEmpty()) return result.file;
+      if (result.artist.isEmpty()) return result.title;
+      return result.title + " - " + result.artist;
+    case Qt::ToolTipRole:
+      return result.album.isEmpty() ? result.file
+                                    : result.album + "\n" + result.file;
+    default:
+      return QVariant();
+  }
+}
+
+Qt::ItemFlags SearchResultsModel::flags(const QModelIndex &index) const {
+  if (!index.isValid()) return Qt::NoItemFlags;
+  return Qt::ItemIsSelectable | Qt::ItemIsDragEnabled | Qt::ItemIsEnabled;
+}
+
+QMimeData *SearchResultsModel::mimeData(const QModelIndexList &indexes) const {
+  QMimeData *mimeData = new QMimeData();
+  QByteArray encodedData;
+  QDataStream stream(&encodedData, QIODevice::WriteOnly);
+
+  // in the order they are shown, streamed last to first like the library
+  QList<int> rows;
+  for (const QModelIndex &index : indexes) rows << index.row();
+  std::sort(rows.begin(), rows.end());
+  for (int i = rows.size() - 1; i >= 0; i--) {
+    stream << results_.at(rows.at(i)).file;
+  }
+
+  mimeData->setData("application/qtmpc_songs_filename_text", encodedData);
+  return mimeData;
+}
+
+void SearchResultsModel::clear(const quint32 searchId) {
+  searchId_ = searchId;
+  if (results_.isEmpty()) return;
+  beginResetModel();
+  results_.clear();
+  endResetModel();
+}
+
+void SearchResultsModel::addResults(const quint32 searchId,
+                                    const QList<MPDSearchResult> &results,
+                                    const bool /*last*/) {
+  // a batch of a search typed over
+  if (searchId != searchId_ || results.isEmpty()) return;
+
+  beginInsertRows(QModelIndex(), results_.size(),
+                  results_.size() + results.size() - 1);
+  results_.append(results);
+  endInsertRows();
+}
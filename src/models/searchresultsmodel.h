@@ -0,0 +1,48 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SEARCHRESULTSMODEL_H
+#define SEARCHRESULTSMODEL_H
+
+#include <QAbstractListModel>
+#include <QList>
+
+#include "../lib/mpdlibrarysearcher.h"
+
+// The results of the current library search, filled batch by batch
+class SearchResultsModel : public QAbstractListModel {
+  Q_OBJECT
+
+ public:
+  explicit SearchResultsModel(QObject *parent = nullptr);
+  int rowCount(const QModelIndex &parent = QModelIndex()) const;
+  QVariant data(const QModelIndex &index, int role) const;
+  Qt::ItemFlags flags(const QModelIndex &index) const;
+  // songs are dragged to the queue like those of the library
+  QMimeData *mimeData(const QModelIndexList &indexes) const;
+
+ public slots:
+  // drops the results shown, only those of searchId are taken from now on
+  void clear(const quint32 searchId);
+  void addResults(const quint32 searchId,
+                  const QList<MPDSearchResult> &results, const bool last);
+
+ private:
+  quint32 searchId_;
+  QList<MPDSearchResult> results_;
+};
+
+#endif  // SEARCHRESULTSMODEL_H
@@ -59,7 +59,21 @@ HEADERS += core/application.h \
     beautify/theme.h \
     lib/mpdlibrarymodel.h \
     models/librarymodel.h \
-    widgets/iconbutton.h
+    widgets/iconbutton.h \
+    lib/mpdcommandlist.h \
+    lib/mpdidlelistener.h \
+    lib/mpdconnectionpool.h \
+    lib/mpdlibrarybuilder.h \
+    lib/mpdstringpool.h \
+    lib/mpdsongtable.h \
+    lib/mpdarena.h \
+    lib/mpdlibrarycache.h \
+    lib/mpdsearchindex.h \
+    lib/mpdlibrarysearcher.h \
+    models/searchresultsmodel.h \
+    widgets/searchwidget.h \
+    models/librarymimedata.h \
+    lib/mpdqueuerange.h
 
 FORMS +=   gui/AboutDialog.ui \
            gui/MpdConnectionDialog.ui \
@@ -104,4 +118,18 @@ SOURCES += main.cpp \
     beautify/theme.cpp \
     lib/mpdlibrarymodel.cpp \
     models/librarymodel.cpp \
-    widgets/iconbutton.cpp
+    widgets/iconbutton.cpp \
+    lib/mpdcommandlist.cpp \
+    lib/mpdidlelistener.cpp \
+    lib/mpdconnectionpool.cpp \
+    lib/mpdlibrarybuilder.cpp \
+    lib/mpdstringpool.cpp \
+    lib/mpdsongtable.cpp \
+    lib/mpdarena.cpp \
+    lib/mpdlibrarycache.cpp \
+    lib/mpdsearchindex.cpp \
+    lib/mpdlibrarysearcher.cpp \
+    models/searchresultsmodel.cpp \
+    widgets/searchwidget.cpp \
+    models/librarymimedata.cpp \
+    lib/mpdqueuerange.cpp
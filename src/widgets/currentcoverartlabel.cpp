@@ -47,7 +47,7 @@ CurrentCoverArtLabel::~CurrentCoverArtLabel() {
 }
 
 void CurrentCoverArtLabel::setCoverArt(QImage *image,
-                                       MPDSongMetadata *songmetadata) {
+                                       MPDSongSnapshot songmetadata) {
   image_ = image;
   songmetadata_ = songmetadata;
 
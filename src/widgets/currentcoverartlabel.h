@@ -15,7 +15,7 @@ class CurrentCoverArtLabel : public QLabel {
   ~CurrentCoverArtLabel();
 
  public slots:
-  void setCoverArt(QImage *image, MPDSongMetadata *songmetadata);
+  void setCoverArt(QImage *image, MPDSongSnapshot songmetadata);
   void setCoverArtAsTodi();
   void setCoverArtTooltip();
 
@@ -28,7 +28,7 @@ class CurrentCoverArtLabel : public QLabel {
   void updateCoverArt();
   Application *app_;
   QImage *image_;
-  MPDSongMetadata *songmetadata_;
+  MPDSongSnapshot songmetadata_;
   QString tooltiptext_;
   QByteArray *imageByteArray_;
   QBuffer *imageBuffer_;
@@ -23,7 +23,7 @@ MetadataWidget::MetadataWidget(QWidget *parent) : QTextEdit (parent) {
 
 MetadataWidget::~MetadataWidget() {}
 
-void MetadataWidget::setMetadata(MPDSongMetadata *songmetadata_) {
+void MetadataWidget::setMetadata(const MPDSongMetadata *songmetadata_) {
   if (!songmetadata_) return;
 
   QString metadatatext_ = QString("<table>");
@@ -28,7 +28,7 @@ class MetadataWidget : public QTextEdit {
   ~MetadataWidget();
 
  public slots:
-  void setMetadata(MPDSongMetadata *songmetadata_);
+  void setMetadata(const MPDSongMetadata *songmetadata_);
 };
 
 #endif  // METADATAWIDGET_H
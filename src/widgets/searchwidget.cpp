@@ -0,0 +1,58 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "searchwidget.h"
+#include "../lib/mpdlibrarysearcher.h"
+#include "../models/searchresultsmodel.h"
+
+#include <QLineEdit>
+#include <QListView>
+#include <QVBoxLayout>
+
+SearchWidget::SearchWidget(MPDLibrarySearcher *searcher, QWidget *parent)
+    : QWidget(parent),
+      searcher_(searcher),
+      query_lineEdit_(new QLineEdit(this)),
+      results_view_(new QListView(this)),
+      results_model_(new SearchResultsModel(this)) {
+  query_lineEdit_->setPlaceholderText(tr("Search library"));
+  query_lineEdit_->setClearButtonEnabled(true);
+  results_view_->setModel(results_model_);
+  results_view_->setUniformItemSizes(true);
+  results_view_->setSelectionMode(QAbstractItemView::ExtendedSelection);
+  results_view_->setDragDropMode(QAbstractItemView::DragOnly);
+
+  QVBoxLayout *layout = new QVBoxLayout(this);
+  layout->setContentsMargins(0, 0, 0, 0);
+  layout->setSpacing(0);
+  layout->addWidget(query_lineEdit_);
+  layout->addWidget(results_view_);
+
+  // every keystroke searches, the search before it is cancelled
+  connect(query_lineEdit_, &QLineEdit::textChanged, this,
+          [this](const QString &query) {
+            results_model_->clear(searcher_->search(query.trimmed()));
+          });
+  connect(searcher_, &MPDLibrarySearcher::resultsFound, results_model_,
+          &SearchResultsModel::addResults);
+}
+
+SearchWidget::~SearchWidget() {}
+
+void SearchWidget::focusQuery() {
+  query_lineEdit_->setFocus();
+  query_lineEdit_->selectAll();
+}
@@ -0,0 +1,46 @@
+/* This file is part of Todi.
+
+   Copyright 2017, Arun Narayanankutty <n.arun.lifescience@gmail.com>
+
+   Todi is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+   Todi is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+   You should have received a copy of the GNU General Public License
+   along with Todi.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SEARCHWIDGET_H
+#define SEARCHWIDGET_H
+
+#include <QWidget>
+
+class MPDLibrarySearcher;
+class QLineEdit;
+class QListView;
+class SearchResultsModel;
+
+// Searches the library as the query is typed
+class SearchWidget : public QWidget {
+  Q_OBJECT
+
+ public:
+  explicit SearchWidget(MPDLibrarySearcher *searcher,
+                        QWidget *parent = nullptr);
+  ~SearchWidget();
+
+ public slots:
+  void focusQuery();
+
+ private:
+  MPDLibrarySearcher *searcher_;
+  QLineEdit *query_lineEdit_;
+  QListView *results_view_;
+  SearchResultsModel *results_model_;
+};
+
+#endif  // SEARCHWIDGET_H